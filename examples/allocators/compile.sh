@@ -0,0 +1,31 @@
+#!/bin/bash
+set -e
+
+cd $(dirname $0)/../..
+
+mkdir -p build
+
+clang++ -std=c++14 -o build/allocators -Iinclude -Wall -O2 \
+  examples/allocators/main.cc                               \
+  include/allocators/atomic_bump.cc                         \
+  include/allocators/bump.cc                                \
+  include/allocators/chained.cc                             \
+  include/allocators/fake.cc                                \
+  include/allocators/pool.cc                                \
+  include/allocators/ring.cc                                \
+  include/allocators/slab.cc                                \
+  include/allocators/stack.cc                               \
+  include/allocators/virtual_bump.cc
+
+# same benchmark with every tracked<A> recording, the flag has to cover the whole build
+clang++ -std=c++14 -o build/allocators_tracked -Iinclude -Wall -O2 -D__TRACKED__ENABLED=1 \
+  examples/allocators/main.cc                                                             \
+  include/allocators/atomic_bump.cc                                                       \
+  include/allocators/bump.cc                                                              \
+  include/allocators/chained.cc                                                           \
+  include/allocators/fake.cc                                                              \
+  include/allocators/pool.cc                                                              \
+  include/allocators/ring.cc                                                              \
+  include/allocators/slab.cc                                                              \
+  include/allocators/stack.cc                                                             \
+  include/allocators/virtual_bump.cc
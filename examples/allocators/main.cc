@@ -0,0 +1,487 @@
+/*
+Benchmark for the allocators in include/allocators
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <allocators/atomic_bump.hh>
+#include <allocators/bump.hh>
+#include <allocators/chained.hh>
+#include <allocators/fake.hh>
+#include <allocators/pool.hh>
+#include <allocators/ring.hh>
+#include <allocators/slab.hh>
+#include <allocators/stack.hh>
+#include <allocators/tracked.hh>
+#include <allocators/virtual_bump.hh>
+#include <common.hh>
+#include <random.hh>
+
+// glibc
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// linux
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define BENCHMARK_REPETITIONS 8
+#define BENCHMARK_WARMUP_REPETITIONS 1
+#define BENCHMARK_JSON_LENGTH (256 * 1024)
+#define BENCHMARK_TEXTURE_LENGTH 1024
+#define BENCHMARK_MIXED_LENGTH (64 * 1024)
+
+struct allocation
+{
+  key Size;
+  key Align;
+};
+
+struct trace
+{
+  const char *Name;
+  key Length;
+  key Requested;
+  key Largest;
+  allocation *Allocations;
+};
+
+struct benchmark_result
+{
+  f64 Nanoseconds;
+  f64 CacheMisses;
+  key Used;
+};
+
+// libc malloc behind the same interface as the other allocators, found by ADL like them
+struct libc_allocator
+{
+  key Used;
+};
+
+void *_Allocate(libc_allocator *Allocator, const key Align, const key Size)
+{
+  void *Output = Align <= alignof(max_align_t) ? malloc(Size) : aligned_alloc(Align, Size);
+  Allocator->Used += malloc_usable_size(Output);
+  return Output;
+}
+
+void Free(libc_allocator *Allocator, void *Memory)
+{
+  Allocator->Used -= malloc_usable_size(Memory);
+  free(Memory);
+}
+
+key MemoryUsed(libc_allocator *Allocator)
+{
+  return Allocator->Used;
+}
+
+inline tick GetNanoseconds()
+{
+  timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return tick(Time.tv_sec) * 1000000000 + tick(Time.tv_nsec);
+}
+
+// returns -1 when the kernel doesn't let us count, e.g. perf_event_paranoid or no PMU in a VM
+i32 OpenCacheMissCounter()
+{
+  perf_event_attr Attributes;
+  memset(&Attributes, 0, sizeof(Attributes));
+  Attributes.type = PERF_TYPE_HARDWARE;
+  Attributes.size = sizeof(Attributes);
+  Attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+  Attributes.disabled = 1;
+  Attributes.exclude_kernel = 1;
+  Attributes.exclude_hv = 1;
+
+  return i32(syscall(SYS_perf_event_open, &Attributes, 0, -1, -1, 0));
+}
+
+inline void StartCounter(const i32 Counter)
+{
+  if (Counter >= 0)
+  {
+    ioctl(Counter, PERF_EVENT_IOC_RESET, 0);
+    ioctl(Counter, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+inline u64 StopCounter(const i32 Counter)
+{
+  u64 Count = 0;
+
+  if (Counter >= 0)
+  {
+    ioctl(Counter, PERF_EVENT_IOC_DISABLE, 0);
+
+    if (read(Counter, &Count, sizeof(Count)) != sizeof(Count))
+    {
+      Count = 0;
+    }
+  }
+
+  return Count;
+}
+
+inline key RandomRange(shift_register *Random, const key Low, const key High)
+{
+  return Low + XorShiftRegisterSeed(Random) % (High - Low + 1);
+}
+
+inline void PushAllocation(trace *Trace, const key Size, const key Align)
+{
+  Trace->Allocations[Trace->Length++] = {.Size = Size, .Align = Align};
+  Trace->Requested += Size;
+  Trace->Largest = Size > Trace->Largest ? Size : Trace->Largest;
+}
+
+trace CreateTrace(const char *Name, const key Capacity)
+{
+  return {
+      .Name = Name,
+      .Length = 0,
+      .Requested = 0,
+      .Largest = 0,
+      .Allocations = SysAllocate(allocation, Capacity),
+  };
+}
+
+// strings, arrays and value headers of examples/json, all small enough for a pool
+void PushJsonValue(trace *Trace, shift_register *Random)
+{
+  switch (XorShiftRegisterSeed(Random) % 3)
+  {
+  case 0:
+    PushAllocation(Trace, 16, 8); // json_string
+    PushAllocation(Trace, RandomRange(Random, 1, 48), 1);
+    break;
+  case 1:
+    PushAllocation(Trace, 16, 8); // json_array
+    PushAllocation(Trace, 16 * RandomRange(Random, 1, 3), 8); // json_value_header
+    break;
+  default:
+    PushAllocation(Trace, 16, 8); // json_string
+    PushAllocation(Trace, RandomRange(Random, 1, 16), 1);
+    break;
+  }
+}
+
+trace CreateJsonValueTrace(shift_register *Random)
+{
+  trace Trace = CreateTrace("json values", BENCHMARK_JSON_LENGTH);
+
+  while (Trace.Length + 2 <= BENCHMARK_JSON_LENGTH)
+  {
+    PushJsonValue(&Trace, Random);
+  }
+
+  return Trace;
+}
+
+// Values mixed with objects and their field tables, 16 or 32 slots of 24 bytes followed by a
+// control byte per slot and a mirrored group of 16.
+trace CreateJsonTrace(shift_register *Random)
+{
+  trace Trace = CreateTrace("json nodes", BENCHMARK_JSON_LENGTH);
+
+  while (Trace.Length + 2 <= BENCHMARK_JSON_LENGTH)
+  {
+    if (XorShiftRegisterSeed(Random) % 4)
+    {
+      PushJsonValue(&Trace, Random);
+    }
+    else
+    {
+      key Slots = key(16) << RandomRange(Random, 0, 1);
+      PushAllocation(&Trace, 64, 8); // json_object
+      PushAllocation(&Trace, 25 * Slots + 16, 8);
+    }
+  }
+
+  return Trace;
+}
+
+// texture header followed by its pixels, power of two sides from 16 to 256
+trace CreateTextureTrace(shift_register *Random)
+{
+  trace Trace = CreateTrace("textures", BENCHMARK_TEXTURE_LENGTH);
+
+  while (Trace.Length + 2 <= BENCHMARK_TEXTURE_LENGTH)
+  {
+    key Width = key(16) << RandomRange(Random, 0, 4);
+    key Height = key(16) << RandomRange(Random, 0, 4);
+    PushAllocation(&Trace, 24, 8);
+    PushAllocation(&Trace, Width * Height * 4, 4);
+  }
+
+  return Trace;
+}
+
+// mostly small objects with the odd large buffer mixed in
+trace CreateMixedTrace(shift_register *Random)
+{
+  trace Trace = CreateTrace("mixed", BENCHMARK_MIXED_LENGTH);
+
+  while (Trace.Length < BENCHMARK_MIXED_LENGTH)
+  {
+    if (XorShiftRegisterSeed(Random) % 16)
+    {
+      PushAllocation(&Trace, RandomRange(Random, 8, 256), key(1) << RandomRange(Random, 0, 3));
+    }
+    else
+    {
+      PushAllocation(&Trace, RandomRange(Random, 4 * KILOBYTE, 256 * KILOBYTE), 16);
+    }
+  }
+
+  return Trace;
+}
+
+// arenas release everything at once, allocators with Free give every allocation back
+template <typename A> void ReleaseAll(A *Allocator, void **Pointers, const key Length)
+{
+  Reset(Allocator);
+}
+
+void ReleaseAll(libc_allocator *Allocator, void **Pointers, const key Length)
+{
+  for (key Index = 0; Index < Length; Index++)
+  {
+    Free(Allocator, Pointers[Index]);
+  }
+}
+
+void ReleaseAll(allocator::pool *Allocator, void **Pointers, const key Length)
+{
+  for (key Index = 0; Index < Length; Index++)
+  {
+    allocator::Free(Allocator, Pointers[Index]);
+  }
+}
+
+void ReleaseAll(allocator::slab *Allocator, void **Pointers, const key Length)
+{
+  for (key Index = 0; Index < Length; Index++)
+  {
+    allocator::Free(Allocator, Pointers[Index]);
+  }
+}
+
+void ReleaseAll(allocator::ring *Allocator, void **Pointers, const key Length)
+{
+  for (key Index = 0; Index < Length; Index++)
+  {
+    allocator::Free(Allocator, Pointers[Index]);
+  }
+
+  // rewind so every repetition reuses the pages the warmup faulted in
+  allocator::Reset(Allocator);
+}
+
+template <typename A>
+void RunBenchmark(const char *Name, A *Allocator, const trace *Trace, void **Pointers,
+                  const i32 Counter)
+{
+  benchmark_result Result = {.Nanoseconds = 0, .CacheMisses = 0, .Used = 0};
+
+  // warmup faults in the pages and blocks arenas keep between resets
+  for (key Repetition = 0; Repetition < BENCHMARK_WARMUP_REPETITIONS + BENCHMARK_REPETITIONS;
+       Repetition++)
+  {
+    StartCounter(Counter);
+    tick Start = GetNanoseconds();
+
+    for (key Index = 0; Index < Trace->Length; Index++)
+    {
+      const allocation *Allocation = &Trace->Allocations[Index];
+      Pointers[Index] = _Allocate(Allocator, Allocation->Align, Allocation->Size);
+    }
+
+    tick Allocated = GetNanoseconds();
+    u64 CacheMisses = StopCounter(Counter);
+    Result.Used = MemoryUsed(Allocator);
+
+    StartCounter(Counter);
+    tick Released = GetNanoseconds();
+    ReleaseAll(Allocator, Pointers, Trace->Length);
+    Released = GetNanoseconds() - Released;
+    CacheMisses += StopCounter(Counter);
+
+    if (Repetition >= BENCHMARK_WARMUP_REPETITIONS)
+    {
+      Result.Nanoseconds += f64(Allocated - Start + Released);
+      Result.CacheMisses += f64(CacheMisses);
+    }
+  }
+
+  f64 Operations = f64(Trace->Length * BENCHMARK_REPETITIONS);
+  key Overhead = Result.Used > Trace->Requested ? Result.Used - Trace->Requested : 0;
+
+  if (Counter >= 0)
+  {
+    fprintf(stdout, "  %-14s %10.2f %14.3f %14lu %9.2f%%\n", Name, Result.Nanoseconds / Operations,
+            Result.CacheMisses / Operations, Overhead,
+            100.0 * f64(Overhead) / f64(Trace->Requested));
+  }
+  else
+  {
+    fprintf(stdout, "  %-14s %10.2f %14s %14lu %9.2f%%\n", Name, Result.Nanoseconds / Operations,
+            "n/a", Overhead, 100.0 * f64(Overhead) / f64(Trace->Requested));
+  }
+}
+
+void RunTrace(const trace *Trace, const i32 Counter)
+{
+  // worst case alignment padding on top of every request
+  key ArenaSize = Trace->Requested + Trace->Length * 16;
+  void **Pointers = SysAllocate(void *, Trace->Length);
+
+  fprintf(stdout, "%s: %lu allocations, %lu bytes requested\n", Trace->Name, Trace->Length,
+          Trace->Requested);
+  fprintf(stdout, "  %-14s %10s %14s %14s %10s\n", "allocator", "ns/op", "misses/op",
+          "overhead", "overhead");
+
+  libc_allocator Libc = {.Used = 0};
+  RunBenchmark("malloc", &Libc, Trace, Pointers, Counter);
+
+  allocator::fake *Fake = allocator::CreateFake();
+  RunBenchmark("fake", Fake, Trace, Pointers, Counter);
+  allocator::Destroy(Fake);
+
+  allocator::bump *Bump = allocator::CreateBump(ArenaSize);
+  RunBenchmark("bump", Bump, Trace, Pointers, Counter);
+  allocator::Destroy(Bump);
+
+  allocator::chained *Chained = allocator::CreateChained(MEGABYTE);
+  RunBenchmark("chained", Chained, Trace, Pointers, Counter);
+  allocator::Destroy(Chained);
+
+  allocator::virtual_bump *VirtualBump = allocator::CreateVirtualBump(ArenaSize);
+  RunBenchmark("virtual_bump", VirtualBump, Trace, Pointers, Counter);
+  allocator::Destroy(VirtualBump);
+
+  allocator::atomic_bump *AtomicBump = allocator::CreateAtomicBump(ArenaSize * 2);
+  RunBenchmark("atomic_bump", AtomicBump, Trace, Pointers, Counter);
+  allocator::Destroy(AtomicBump);
+
+  allocator::stack *Stack = allocator::CreateStack(ArenaSize);
+  RunBenchmark("stack", &Stack->Front, Trace, Pointers, Counter);
+  allocator::Destroy(Stack);
+
+  allocator::ring *Ring = allocator::CreateRing(ArenaSize + Trace->Length * 16);
+  RunBenchmark("ring", Ring, Trace, Pointers, Counter);
+  allocator::Destroy(Ring);
+
+  // pool slots are a single size, only worth it when every request is small
+  if (Trace->Largest <= 64)
+  {
+    allocator::pool *Pool = allocator::CreatePool(Trace->Largest);
+    RunBenchmark("pool", Pool, Trace, Pointers, Counter);
+    allocator::Destroy(Pool);
+  }
+
+  allocator::slab *Slab = allocator::CreateSlab();
+  RunBenchmark("slab", Slab, Trace, Pointers, Counter);
+  allocator::Destroy(Slab);
+
+  SysFree(Pointers);
+  fprintf(stdout, "\n");
+}
+
+#if __TRACKED__ENABLED
+// Replays every trace once through a tracked slab and reports the statistics of each.
+void RunTracked(const trace *Traces, const key Count)
+{
+  allocator::slab **Slabs = SysAllocate(allocator::slab *, Count);
+  allocator::tracked<allocator::slab> **Tracked =
+      SysAllocate(allocator::tracked<allocator::slab> *, Count);
+
+  for (key Index = 0; Index < Count; Index++)
+  {
+    const trace *Trace = &Traces[Index];
+    void **Pointers = SysAllocate(void *, Trace->Length);
+    Slabs[Index] = allocator::CreateSlab();
+    Tracked[Index] = allocator::CreateTracked(Slabs[Index], Trace->Name);
+
+    for (key Allocation = 0; Allocation < Trace->Length; Allocation++)
+    {
+      const allocation *Shape = &Trace->Allocations[Allocation];
+      Pointers[Allocation] = allocator::_Allocate(Tracked[Index], Shape->Align, Shape->Size);
+    }
+
+    for (key Allocation = 0; Allocation < Trace->Length; Allocation++)
+    {
+      allocator::Free(Tracked[Index], Pointers[Allocation]);
+    }
+
+    SysFree(Pointers);
+  }
+
+  fprintf(stdout, "tracked slab, every trace replayed once:\n");
+  allocator::ReportAll(stdout);
+  fprintf(stdout, "\n");
+
+  for (key Index = 0; Index < Count; Index++)
+  {
+    allocator::Destroy(Tracked[Index]);
+    allocator::Destroy(Slabs[Index]);
+  }
+
+  SysFree(Tracked);
+  SysFree(Slabs);
+}
+#endif
+
+i32 main(i32 Argc, const char *Argv[])
+{
+  shift_register Random = {.Seed = 0x2545F491};
+  i32 Counter = OpenCacheMissCounter();
+
+  if (Counter < 0)
+  {
+    fprintf(stdout, "Cache miss counter unavailable, check perf_event_paranoid.\n\n");
+  }
+
+  trace Traces[] = {
+      CreateJsonTrace(&Random),
+      CreateJsonValueTrace(&Random),
+      CreateTextureTrace(&Random),
+      CreateMixedTrace(&Random),
+  };
+
+#if __TRACKED__ENABLED
+  RunTracked(Traces, ArrayLength(Traces));
+#endif
+
+  for (key Index = 0; Index < ArrayLength(Traces); Index++)
+  {
+    RunTrace(&Traces[Index], Counter);
+    SysFree(Traces[Index].Allocations);
+  }
+
+  if (Counter >= 0)
+  {
+    close(Counter);
+  }
+
+  return 0;
+}
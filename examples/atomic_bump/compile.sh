@@ -0,0 +1,11 @@
+#!/bin/bash
+set -e
+
+cd $(dirname $0)/../..
+
+mkdir -p build
+
+clang++ -std=c++14 -o build/atomic_bump -Iinclude -Wall -O2 -lpthread \
+  examples/atomic_bump/main.cc                                         \
+  include/allocators/atomic_bump.cc                                    \
+  include/allocators/bump.cc
@@ -0,0 +1,176 @@
+/*
+Contention benchmark for allocators/atomic_bump.hh
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <allocators/atomic_bump.hh>
+#include <allocators/bump.hh>
+#include <common.hh>
+
+// glibc
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCHMARK_ALLOCATIONS_PER_THREAD (1024 * 1024)
+#define BENCHMARK_MAX_THREADS 64
+
+// Size and alignment of the nodes examples/json allocates, in the order a typical object produces
+struct allocation_shape
+{
+  key Size;
+  key Align;
+};
+
+static const allocation_shape JsonShapes[] = {
+    {64, 8},  // json_object
+    {416, 8}, // json_object field table, 16 slots of 24 bytes and their control bytes
+    {16, 8}, // json_string
+    {12, 1}, // json_string buffer
+    {16, 8}, // json_array
+    {16, 8}, // json_value_header
+    {5, 1},  // json_string buffer
+    {16, 8}, // json_string
+};
+
+struct benchmark_thread
+{
+  pthread_t Thread;
+  void *Allocator;
+  pthread_mutex_t *Lock;
+  pthread_barrier_t *Barrier;
+};
+
+inline tick GetNanoseconds()
+{
+  timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return tick(Time.tv_sec) * 1000000000 + tick(Time.tv_nsec);
+}
+
+void *RunAtomicBump(void *Argument)
+{
+  benchmark_thread *Thread = (benchmark_thread *)Argument;
+  allocator::atomic_bump *Allocator = (allocator::atomic_bump *)Thread->Allocator;
+  pthread_barrier_wait(Thread->Barrier);
+
+  for (key Index = 0; Index < BENCHMARK_ALLOCATIONS_PER_THREAD; Index++)
+  {
+    const allocation_shape *Shape = &JsonShapes[Index % ArrayLength(JsonShapes)];
+    byte *Memory = (byte *)allocator::_Allocate(Allocator, Shape->Align, Shape->Size);
+    Memory[0] = byte(Index);
+  }
+
+  return 0x0;
+}
+
+void *RunLockedBump(void *Argument)
+{
+  benchmark_thread *Thread = (benchmark_thread *)Argument;
+  allocator::bump *Allocator = (allocator::bump *)Thread->Allocator;
+  pthread_barrier_wait(Thread->Barrier);
+
+  for (key Index = 0; Index < BENCHMARK_ALLOCATIONS_PER_THREAD; Index++)
+  {
+    const allocation_shape *Shape = &JsonShapes[Index % ArrayLength(JsonShapes)];
+    pthread_mutex_lock(Thread->Lock);
+    byte *Memory = (byte *)allocator::_Allocate(Allocator, Shape->Align, Shape->Size);
+    pthread_mutex_unlock(Thread->Lock);
+    Memory[0] = byte(Index);
+  }
+
+  return 0x0;
+}
+
+f64 RunBenchmark(const key ThreadCount, void *(*Run)(void *), void *Allocator)
+{
+  benchmark_thread Threads[BENCHMARK_MAX_THREADS];
+  pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_barrier_t Barrier;
+  pthread_barrier_init(&Barrier, 0x0, ThreadCount + 1);
+
+  for (key Index = 0; Index < ThreadCount; Index++)
+  {
+    Threads[Index].Allocator = Allocator;
+    Threads[Index].Lock = &Lock;
+    Threads[Index].Barrier = &Barrier;
+    pthread_create(&Threads[Index].Thread, 0x0, Run, &Threads[Index]);
+  }
+
+  pthread_barrier_wait(&Barrier);
+  tick Start = GetNanoseconds();
+
+  for (key Index = 0; Index < ThreadCount; Index++)
+  {
+    pthread_join(Threads[Index].Thread, 0x0);
+  }
+
+  tick Elapsed = GetNanoseconds() - Start;
+  pthread_barrier_destroy(&Barrier);
+
+  return f64(Elapsed) / f64(ThreadCount * BENCHMARK_ALLOCATIONS_PER_THREAD);
+}
+
+// Arg1 is the optional maximum thread count, defaults to the online processor count
+i32 main(i32 Argc, const char *Argv[])
+{
+  key MaxThreads = Argc > 1 ? key(atoi(Argv[1])) : key(sysconf(_SC_NPROCESSORS_ONLN));
+  MaxThreads = MaxThreads < 1 ? 1 : MaxThreads;
+  MaxThreads = MaxThreads > BENCHMARK_MAX_THREADS ? BENCHMARK_MAX_THREADS : MaxThreads;
+
+  // worst case is every allocation fully padded
+  key ShapesSize = 0;
+
+  for (key Index = 0; Index < ArrayLength(JsonShapes); Index++)
+  {
+    ShapesSize += JsonShapes[Index].Size + JsonShapes[Index].Align - 1;
+  }
+
+  key Rounds = BENCHMARK_ALLOCATIONS_PER_THREAD / ArrayLength(JsonShapes) + 1;
+  key ArenaSize = MaxThreads * Rounds * ShapesSize;
+  allocator::atomic_bump *AtomicBump = allocator::CreateAtomicBump(ArenaSize);
+  allocator::bump *Bump = allocator::CreateBump(ArenaSize);
+
+  if (!AtomicBump || !Bump)
+  {
+    allocator::Destroy(AtomicBump);
+    allocator::Destroy(Bump);
+    fprintf(stdout, "Failed to allocate %lu bytes for benchmark arenas.\n", ArenaSize);
+    return 1;
+  }
+
+  fprintf(stdout, "%8s %20s %20s %16s %16s\n", "threads", "atomic_bump ns/op", "mutex+bump ns/op",
+          "atomic_bump used", "bump used");
+
+  for (key ThreadCount = 1; ThreadCount <= MaxThreads; ThreadCount++)
+  {
+    allocator::Reset(AtomicBump);
+    allocator::Reset(Bump);
+
+    f64 AtomicTime = RunBenchmark(ThreadCount, RunAtomicBump, AtomicBump);
+    f64 LockedTime = RunBenchmark(ThreadCount, RunLockedBump, Bump);
+
+    fprintf(stdout, "%8lu %20.2f %20.2f %16lu %16lu\n", ThreadCount, AtomicTime, LockedTime,
+            allocator::MemoryUsed(AtomicBump), allocator::MemoryUsed(Bump));
+  }
+
+  allocator::Destroy(AtomicBump);
+  allocator::Destroy(Bump);
+
+  return 0;
+}
@@ -5,7 +5,8 @@ cd $(dirname $0)/../..
 
 mkdir -p build
 
-clang++ -std=c++14 -o build/audio_d -Iinclude -Iexamples/common -Wall -lpulse -g \
-  examples/audio/main.cc                                                         \
-  include/riff.cc                                                                \
+clang++ -std=c++14 -o build/audio_d -Iinclude -Iexamples/common -Wall -lpulse -lpthread -g \
+  examples/audio/main.cc                                                                   \
+  include/buffer.cc                                                                        \
+  include/riff.cc                                                                          \
   include/wav.cc
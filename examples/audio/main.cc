@@ -16,6 +16,7 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <buffer.hh>
 #include <common.hh>
 #include <mixer.hh>
 #include <wav.hh>
@@ -192,6 +193,21 @@ void ShutdownPulseAudio(pulse_audio *PulseAudio)
   pa_mainloop_free(PulseAudio->MainLoop);
 }
 
+// The sounds read their samples from these mappings, only released once nothing plays them.
+void ReleaseSounds(wav::audio *Audios, buffer *WavBuffers, const key AudioCount)
+{
+  for (key AudioIndex = 0; AudioIndex < AudioCount; AudioIndex++)
+  {
+    if (IsInitialized(WavBuffers[AudioIndex]))
+    {
+      UnmapBuffer(WavBuffers[AudioIndex]);
+    }
+  }
+
+  SysFree(WavBuffers);
+  SysFree(Audios);
+}
+
 i32 main(i32 Argc, char *Argv[])
 {
   if (Argc < 2)
@@ -202,35 +218,28 @@ i32 main(i32 Argc, char *Argv[])
 
   key AudioCount = Argc - 1;
   wav::audio *Audios = SysAllocate(wav::audio, AudioCount);
+  buffer *WavBuffers = SysAllocate(buffer, AudioCount);
   key LongestAudio = 0;
 
   for (key AudioIndex = 0; AudioIndex < AudioCount; AudioIndex++)
   {
-    FILE *File = fopen(Argv[AudioIndex + 1], "r");
-    key WavLength = 0;
-    void *WavData = 0x0;
+    // samples are read in place from the mapping for as long as the audio plays
+    buffer *WavBuffer = &WavBuffers[AudioIndex];
+    *WavBuffer = MapBufferFromFile(Argv[AudioIndex + 1], BUFFER_ACCESS_SEQUENTIAL);
 
-    if (File)
-    {
-      fseek(File, 0, SEEK_END);
-      WavLength = ftell(File);
-      WavData = SysAllocate(byte, WavLength);
-      rewind(File);
-      fread(WavData, 1, WavLength, File);
-
-      fclose(File);
-    }
-    else
+    if (!IsInitialized(*WavBuffer))
     {
       fprintf(stdout, "Failed to read WAV file.\n");
+      ReleaseSounds(Audios, WavBuffers, AudioCount);
       return 1;
     }
 
-    Audios[AudioIndex] = wav::GetAudio(WavLength, WavData);
+    Audios[AudioIndex] = wav::GetAudio(WavBuffer->Length, WavBuffer->Data);
 
     if (Audios[AudioIndex].SampleCount == 0)
     {
       fprintf(stdout, "Failed to parse WAV file '%s'.\n", Argv[AudioIndex + 1]);
+      ReleaseSounds(Audios, WavBuffers, AudioCount);
       return 1;
     }
 
@@ -241,6 +250,7 @@ i32 main(i32 Argc, char *Argv[])
   if (InitializePulseAudio(&PulseAudio) == 0)
   {
     fprintf(stdout, "Failed to initialize PulseAudio.\n");
+    ReleaseSounds(Audios, WavBuffers, AudioCount);
     return 1;
   }
 
@@ -326,4 +336,5 @@ i32 main(i32 Argc, char *Argv[])
   }
 
   ShutdownPulseAudio(&PulseAudio);
+  ReleaseSounds(Audios, WavBuffers, AudioCount);
 }
@@ -0,0 +1,10 @@
+#!/bin/bash
+set -e
+
+cd $(dirname $0)/../..
+
+mkdir -p build
+
+clang++ -std=c++14 -o build/compact -Iinclude -Wall -O2 \
+  examples/compact/main.cc                               \
+  include/allocators/compact.cc
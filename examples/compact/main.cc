@@ -0,0 +1,163 @@
+/*
+Example for the handle based compacting allocator
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <allocators/compact.hh>
+#include <common.hh>
+#include <random.hh>
+
+// glibc
+#include <stdio.h>
+
+#define COMPACT_HEAP_SIZE (16 * MEGABYTE)
+#define COMPACT_HANDLE_COUNT 4096
+#define COMPACT_MAX_BLOCK (8 * KILOBYTE)
+#define COMPACT_FRAME_BUDGET 50000 // ns of defrag per simulated frame
+
+struct asset
+{
+  allocator::compact_handle Handle;
+  key Size;
+  bool32 Live;
+};
+
+inline byte Pattern(const key Asset, const key Offset)
+{
+  return byte(Asset * 131 + Offset * 7);
+}
+
+void Fill(allocator::compact *Heap, const asset *Asset, const key Index)
+{
+  byte *Memory = GetPointerAs(Heap, Asset->Handle, byte);
+
+  for (key Offset = 0; Offset < Asset->Size; Offset++)
+  {
+    Memory[Offset] = Pattern(Index, Offset);
+  }
+}
+
+// Every live handle still resolves to its own bytes and every freed one is rejected.
+bool32 Check(allocator::compact *Heap, const asset *Assets, const key Count)
+{
+  for (key Index = 0; Index < Count; Index++)
+  {
+    const asset *Asset = &Assets[Index];
+
+    if (!Asset->Live)
+    {
+      if (allocator::IsValid(Heap, Asset->Handle))
+      {
+        return false;
+      }
+
+      continue;
+    }
+
+    const byte *Memory = GetPointerAs(Heap, Asset->Handle, byte);
+
+    for (key Offset = 0; Offset < Asset->Size; Offset++)
+    {
+      if (Memory[Offset] != Pattern(Index, Offset))
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Fills the heap with assets of random sizes, frees about half of them and defrags a little every
+// frame until the holes are gone, checking the contents behind every handle after each frame.
+// Exits with 1 when a handle lost its data.
+i32 main()
+{
+  shift_register Random = {.Seed = 0x2545F491};
+  allocator::compact *Heap = allocator::CreateCompact(COMPACT_HEAP_SIZE, COMPACT_HANDLE_COUNT);
+  asset *Assets = SysAllocate(asset, COMPACT_HANDLE_COUNT);
+  key Count = 0;
+
+  for (; Count < COMPACT_HANDLE_COUNT; Count++)
+  {
+    asset *Asset = &Assets[Count];
+    Asset->Size = 1 + XorShiftRegisterSeed(&Random) % COMPACT_MAX_BLOCK;
+    Asset->Handle = allocator::AllocateHandle(Heap, 16, Asset->Size);
+    Asset->Live = allocator::IsValid(Heap, Asset->Handle);
+
+    if (!Asset->Live)
+    {
+      break;
+    }
+
+    Fill(Heap, Asset, Count);
+  }
+
+  for (key Index = 0; Index < Count; Index++)
+  {
+    if (XorShiftRegisterSeed(&Random) % 2)
+    {
+      allocator::Free(Heap, Assets[Index].Handle);
+      Assets[Index].Live = false;
+    }
+  }
+
+  fprintf(stdout, "%lu assets, %lu bytes live, %lu bytes fragmented\n", Count,
+          allocator::MemoryUsed(Heap), allocator::MemoryFragmented(Heap));
+
+  bool32 Passed = Check(Heap, Assets, Count);
+  key Frames = 0;
+
+  while (Passed && !allocator::Defrag(Heap, COMPACT_FRAME_BUDGET))
+  {
+    Frames++;
+    Passed = Check(Heap, Assets, Count);
+  }
+
+  Passed = Passed && Check(Heap, Assets, Count) && allocator::MemoryFragmented(Heap) == 0;
+
+  fprintf(stdout, "defragmented in %lu frames of %d ns, %lu bytes fragmented\n", Frames + 1,
+          COMPACT_FRAME_BUDGET, allocator::MemoryFragmented(Heap));
+
+  // the reclaimed room at the end takes new assets again
+  key Refilled = 0;
+
+  for (key Index = 0; Passed && Index < Count; Index++)
+  {
+    asset *Asset = &Assets[Index];
+
+    if (!Asset->Live)
+    {
+      Asset->Handle = allocator::AllocateHandle(Heap, 16, Asset->Size);
+      Asset->Live = allocator::IsValid(Heap, Asset->Handle);
+      Passed = Asset->Live;
+
+      if (Passed)
+      {
+        Fill(Heap, Asset, Index);
+        Refilled++;
+      }
+    }
+  }
+
+  Passed = Passed && Check(Heap, Assets, Count);
+  fprintf(stdout, "refilled %lu assets, %s\n", Refilled, Passed ? "ok" : "FAIL");
+
+  SysFree(Assets);
+  allocator::Destroy(Heap);
+
+  return Passed ? 0 : 1;
+}
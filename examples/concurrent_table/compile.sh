@@ -0,0 +1,10 @@
+#!/bin/bash
+set -e
+
+cd $(dirname $0)/../..
+
+mkdir -p build
+
+clang++ -std=c++14 -o build/concurrent_table -Iinclude -Wall -O2 -lpthread \
+  examples/concurrent_table/main.cc                                         \
+  include/allocators/atomic_bump.cc
@@ -0,0 +1,267 @@
+/*
+Example program to use concurrent_table.hh
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <allocators/atomic_bump.hh>
+#include <cartridge.hh>
+#include <common.hh>
+#include <concurrent_table.hh>
+#include <hash.hh>
+
+// glibc
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define CACHE_ASSETS 4096
+#define CACHE_ROUNDS 8
+#define CACHE_MAX_THREADS 64
+// every Nth asset fails to decode, its entry is abandoned instead of published
+#define CACHE_MISSING_EVERY 7
+// mixing rounds standing in for a decode, long enough for the other threads to pile up on Wait
+#define CACHE_DECODE_WORK 2000
+
+struct cached_asset
+{
+  key Index;
+  hash::digest Checksum;
+};
+
+typedef hash::concurrent_table<cached_asset, allocator::atomic_bump> asset_cache;
+
+// What every thread of a round shares, Decodes counts how often each asset was decoded.
+struct cache_round
+{
+  asset_cache *Cache;
+  const hash::digest *IDs;
+  u32 *Decodes;
+  pthread_barrier_t *Barrier;
+};
+
+struct cache_thread
+{
+  pthread_t Thread;
+  cache_round *Round;
+  key Shared;
+  bool32 Failed;
+};
+
+inline bool32 IsMissing(const key Index)
+{
+  return Index % CACHE_MISSING_EVERY == 0;
+}
+
+inline hash::digest DecodeChecksum(const hash::digest ID)
+{
+  hash::digest Checksum = ID;
+
+  for (key Step = 0; Step < CACHE_DECODE_WORK; Step++)
+  {
+    Checksum = hash::Mix(Checksum, (const char *)&ID, sizeof(ID));
+  }
+
+  return Checksum;
+}
+
+// Every thread asks for the assets in the same order so they race on the same keys. Whoever claims
+// one decodes it, the others wait on the claim and must get the same value or 0x0 when abandoned.
+void *RunLoader(void *Argument)
+{
+  cache_thread *Thread = (cache_thread *)Argument;
+  cache_round *Round = Thread->Round;
+  pthread_barrier_wait(Round->Barrier);
+
+  for (key Index = 0; Index < CACHE_ASSETS; Index++)
+  {
+    bool32 Claimed;
+    hash::concurrent_entry<cached_asset> *Entry =
+        hash::Claim(Round->Cache, Round->IDs[Index], &Claimed);
+
+    if (!Entry)
+    {
+      Thread->Failed = true;
+      continue;
+    }
+
+    if (Claimed)
+    {
+      __atomic_fetch_add(&Round->Decodes[Index], 1, __ATOMIC_RELAXED);
+
+      if (IsMissing(Index))
+      {
+        hash::Abandon(Round->Cache, Entry);
+      }
+      else
+      {
+        hash::Publish(Round->Cache, Entry, {Index, DecodeChecksum(Round->IDs[Index])});
+      }
+    }
+    else
+    {
+      Thread->Shared++;
+    }
+
+    cached_asset *Asset = hash::Wait(Round->Cache, Entry);
+
+    if (IsMissing(Index) ? Asset != 0x0
+                         : !Asset || Asset->Index != Index ||
+                               Asset->Checksum != DecodeChecksum(Round->IDs[Index]))
+    {
+      Thread->Failed = true;
+    }
+  }
+
+  return 0x0;
+}
+
+// After the threads are done every asset must have been decoded once, and the lock free Find must
+// agree with what the threads waited for.
+bool32 CheckCache(const cache_round *Round)
+{
+  bool32 Passed = hash::Count(Round->Cache) == CACHE_ASSETS;
+
+  for (key Index = 0; Passed && Index < CACHE_ASSETS; Index++)
+  {
+    cached_asset *Asset = hash::Find(Round->Cache, Round->IDs[Index]);
+    Passed = Round->Decodes[Index] == 1 && (IsMissing(Index) ? !Asset : Asset->Index == Index);
+  }
+
+  // Insert is a claim and publish in one, it must leave what is already there alone
+  cached_asset *Existing = hash::Insert(Round->Cache, Round->IDs[1], {0, 0});
+  Passed = Passed && Existing && Existing->Index == 1;
+  Passed = Passed && !hash::Insert(Round->Cache, Round->IDs[0], {0, 0});
+
+  return Passed;
+}
+
+// A table created for a single key refuses new ones once its buckets average
+// __CONCURRENT__MAX_LOAD entries, keys already in it are still found.
+bool32 CheckLoadLimit(allocator::atomic_bump *Allocator, const hash::digest *IDs)
+{
+  allocator::Reset(Allocator);
+  asset_cache *Cache = hash::CreateConcurrentTable<cached_asset>(Allocator, 1);
+
+  if (!Cache)
+  {
+    return false;
+  }
+
+  key Limit = __CONCURRENT__MIN_BUCKETS * __CONCURRENT__MAX_LOAD;
+  bool32 Passed = true;
+
+  for (key Index = 0; Passed && Index < Limit; Index++)
+  {
+    Passed = hash::Insert(Cache, IDs[Index], {Index, 0}) != 0x0;
+  }
+
+  bool32 Claimed;
+  Passed = Passed && !hash::Claim(Cache, IDs[Limit], &Claimed) && !Claimed;
+  Passed = Passed && hash::Count(Cache) == Limit && hash::Find(Cache, IDs[Limit - 1]);
+  hash::Destroy(Cache);
+
+  return Passed;
+}
+
+// Arg1 is the optional thread count, defaults to the online processor count. Exits with 1 when an
+// asset was decoded twice, a thread saw the wrong value or the load limit wasn't enforced.
+i32 main(i32 Argc, const char *Argv[])
+{
+  key ThreadCount = Argc > 1 ? key(atoi(Argv[1])) : key(sysconf(_SC_NPROCESSORS_ONLN));
+  ThreadCount = ThreadCount < 2 ? 2 : ThreadCount;
+  ThreadCount = ThreadCount > CACHE_MAX_THREADS ? CACHE_MAX_THREADS : ThreadCount;
+
+  // asset IDs as a cartridge would store them
+  hash::digest *IDs = SysAllocate(hash::digest, CACHE_ASSETS);
+  u32 *Decodes = SysAllocate(u32, CACHE_ASSETS);
+
+  for (key Index = 0; Index < CACHE_ASSETS; Index++)
+  {
+    char Path[64];
+    snprintf(Path, sizeof(Path), "textures/asset_%04lu.tga", Index);
+    IDs[Index] = crpk::AssetKey(Path).ID;
+  }
+
+  key ArenaSize = CACHE_ASSETS * sizeof(hash::concurrent_entry<cached_asset>);
+  allocator::atomic_bump *Allocator = allocator::CreateAtomicBump(ArenaSize);
+
+  if (!Allocator)
+  {
+    fprintf(stdout, "Failed to allocate %lu bytes for the cache entries.\n", ArenaSize);
+    return 1;
+  }
+
+  bool32 Passed = true;
+  key Shared = 0;
+  cache_thread Threads[CACHE_MAX_THREADS];
+  pthread_barrier_t Barrier;
+  pthread_barrier_init(&Barrier, 0x0, ThreadCount);
+
+  for (key RoundIndex = 0; Passed && RoundIndex < CACHE_ROUNDS; RoundIndex++)
+  {
+    allocator::Reset(Allocator);
+    cache_round Round = {
+        .Cache = hash::CreateConcurrentTable<cached_asset>(Allocator, CACHE_ASSETS),
+        .IDs = IDs,
+        .Decodes = Decodes,
+        .Barrier = &Barrier,
+    };
+
+    if (!Round.Cache)
+    {
+      fprintf(stdout, "Failed to create the asset cache.\n");
+      Passed = false;
+      break;
+    }
+
+    for (key Index = 0; Index < CACHE_ASSETS; Index++)
+    {
+      Decodes[Index] = 0;
+    }
+
+    for (key Index = 0; Index < ThreadCount; Index++)
+    {
+      Threads[Index] = {.Round = &Round, .Shared = 0, .Failed = false};
+      pthread_create(&Threads[Index].Thread, 0x0, RunLoader, &Threads[Index]);
+    }
+
+    for (key Index = 0; Index < ThreadCount; Index++)
+    {
+      pthread_join(Threads[Index].Thread, 0x0);
+      Passed = Passed && !Threads[Index].Failed;
+      Shared += Threads[Index].Shared;
+    }
+
+    Passed = Passed && CheckCache(&Round);
+    hash::Destroy(Round.Cache);
+  }
+
+  fprintf(stdout, "%lu threads, %d rounds of %d assets, %lu requests served by another claim: %s\n",
+          ThreadCount, CACHE_ROUNDS, CACHE_ASSETS, Shared, Passed ? "ok" : "FAIL");
+
+  bool32 LimitPassed = CheckLoadLimit(Allocator, IDs);
+  fprintf(stdout, "keys past %d per bucket refused: %s\n", __CONCURRENT__MAX_LOAD,
+          LimitPassed ? "ok" : "FAIL");
+  Passed = Passed && LimitPassed;
+
+  pthread_barrier_destroy(&Barrier);
+  allocator::Destroy(Allocator);
+  SysFree(Decodes);
+  SysFree(IDs);
+
+  return Passed ? 0 : 1;
+}
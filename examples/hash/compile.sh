@@ -0,0 +1,15 @@
+#!/bin/bash
+set -e
+
+cd $(dirname $0)/../..
+
+mkdir -p build
+
+clang++ -std=c++14 -o build/hash -Iinclude -Wall -O2 -lpthread \
+  examples/hash/main.cc                                         \
+  include/allocators/slab.cc
+
+# same checks with hash::table matching groups through SWAR instead of SSE2
+clang++ -std=c++14 -o build/hash_swar -Iinclude -Wall -O2 -U__SSE2__ -lpthread \
+  examples/hash/main.cc                                                        \
+  include/allocators/slab.cc
@@ -0,0 +1,931 @@
+/*
+Quality and throughput benchmark for hash.hh
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <allocators/slab.hh>
+#include <common.hh>
+#include <hash.hh>
+#include <hash_table.hh>
+#include <random.hh>
+
+// glibc
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCHMARK_SHORT_HASHES (4 * 1024 * 1024)
+#define BENCHMARK_SHORT_BUFFER (64 * KILOBYTE)
+#define BENCHMARK_LONG_LENGTH (256 * MEGABYTE)
+#define BENCHMARK_CACHED_LENGTH (64 * KILOBYTE)
+#define BENCHMARK_STREAM_CHUNK (4 * KILOBYTE)
+#define BENCHMARK_REPETITIONS 4
+#define BENCHMARK_AVALANCHE_SAMPLES 8192
+#define BENCHMARK_AVALANCHE_INPUT_BITS 256
+#define BENCHMARK_TABLE_KEYS (1024 * 1024)
+#define BENCHMARK_PATH_COUNT (128 * 1024)
+#define BENCHMARK_FIELD_COUNT (64 * 1024)
+#define BENCHMARK_GRID_SIDE 512
+#define BENCHMARK_WIDE_GRID_COUNT (256 * 1024)
+#define BENCHMARK_CHECK_KEYS 4096
+#define BENCHMARK_CHECK_PHASE (64 * 1024)
+#define BENCHMARK_CHECK_PHASES 32
+#define BENCHMARK_CHURN_CAPACITY 1024
+#define BENCHMARK_CHURN_PAIRS 10000
+#define BENCHMARK_MATCH_SHORT 256
+#define BENCHMARK_MATCH_SECOND_SEED 0x9E3779B9
+
+// Fails any cell of the avalanche matrix further than this from 50% flips. With 8192 samples one
+// standard deviation is about 0.55%, the worst of the up to 256 x 64 cells lands around 4 of them
+// so runs of a sound hash show up to ~2.3%.
+#define BENCHMARK_BIAS_LIMIT 0.03
+
+// Hashes an input of InputBits bits, Input is BENCHMARK_AVALANCHE_INPUT_BITS / 8 bytes.
+typedef hash::digest (*avalanche_function)(const byte *Input);
+
+struct avalanche_result
+{
+  f64 MeanFlip;
+  f64 WorstBias;
+  key WorstInput;
+  key WorstOutput;
+  f64 WorstOutputBias; // how far any single output bit is from being set half the time
+};
+
+struct key_set
+{
+  const char *Name;
+  key Length;
+  hash::digest *Digests;
+};
+
+// digests are summed here so the timed loops can't be optimized out
+u64 Sink = 0;
+
+inline tick GetNanoseconds()
+{
+  timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return tick(Time.tv_sec) * 1000000000 + tick(Time.tv_nsec);
+}
+
+inline u64 Random64(shift_register *Random)
+{
+  return u64(XorShiftRegisterSeed(Random)) << 32 | u64(XorShiftRegisterSeed(Random));
+}
+
+void FillRandom(shift_register *Random, byte *Data, const key Length)
+{
+  for (key Index = 0; Index < Length; Index++)
+  {
+    Data[Index] = byte(XorShiftRegisterSeed(Random));
+  }
+}
+
+inline f64 GigabytesPerSecond(const f64 Bytes, const tick Nanoseconds)
+{
+  return Bytes / f64(Nanoseconds);
+}
+
+// Many short keys at shifting offsets, every digest is independent so this measures throughput
+// rather than the latency of a single hash.
+void RunShortKeys(const byte *Buffer)
+{
+  static const key Lengths[] = {4, 8, 12, 16, 24, 32, 48, 64, 96, 128};
+
+  fprintf(stdout, "short keys: %d hashes per length\n", BENCHMARK_SHORT_HASHES);
+  fprintf(stdout, "  %-8s %10s %10s\n", "bytes", "ns/hash", "GB/s");
+
+  for (key Index = 0; Index < ArrayLength(Lengths); Index++)
+  {
+    key Length = Lengths[Index];
+    key Window = BENCHMARK_SHORT_BUFFER - Length;
+    tick Best = ~tick(0);
+
+    for (key Repetition = 0; Repetition < BENCHMARK_REPETITIONS; Repetition++)
+    {
+      tick Start = GetNanoseconds();
+
+      for (key Hash = 0; Hash < BENCHMARK_SHORT_HASHES; Hash++)
+      {
+        Sink += hash::Mix((const char *)Buffer + (Hash * 61) % Window, Length);
+      }
+
+      tick Elapsed = GetNanoseconds() - Start;
+      Best = Elapsed < Best ? Elapsed : Best;
+    }
+
+    fprintf(stdout, "  %-8lu %10.2f %10.2f\n", Length, f64(Best) / BENCHMARK_SHORT_HASHES,
+            GigabytesPerSecond(f64(Length) * BENCHMARK_SHORT_HASHES, Best));
+  }
+
+  tick Best = ~tick(0);
+
+  for (key Repetition = 0; Repetition < BENCHMARK_REPETITIONS; Repetition++)
+  {
+    tick Start = GetNanoseconds();
+
+    for (u32 Hash = 0; Hash < BENCHMARK_SHORT_HASHES; Hash++)
+    {
+      Sink += hash::Mix(Hash);
+    }
+
+    tick Elapsed = GetNanoseconds() - Start;
+    Best = Elapsed < Best ? Elapsed : Best;
+  }
+
+  fprintf(stdout, "  %-8s %10.2f %10.2f\n", "u32", f64(Best) / BENCHMARK_SHORT_HASHES,
+          GigabytesPerSecond(4.0 * BENCHMARK_SHORT_HASHES, Best));
+  fprintf(stdout, "\n");
+}
+
+void PrintLong(const char *Name, const key Length, const tick Nanoseconds)
+{
+  fprintf(stdout, "  %-28s %10.2f\n", Name, GigabytesPerSecond(f64(Length), Nanoseconds));
+}
+
+// Cached is hashed from L1/L2, the others stream the whole buffer from memory.
+void RunLongKeys(const byte *Buffer, const u32 ThreadCount)
+{
+  const char *Data = (const char *)Buffer;
+  tick Cached = ~tick(0), Whole = ~tick(0), Streamed = ~tick(0), Tree = ~tick(0);
+
+  for (key Repetition = 0; Repetition < BENCHMARK_REPETITIONS; Repetition++)
+  {
+    tick Start = GetNanoseconds();
+
+    for (key Offset = 0; Offset < BENCHMARK_LONG_LENGTH; Offset += BENCHMARK_CACHED_LENGTH)
+    {
+      Sink += hash::Mix(Data, BENCHMARK_CACHED_LENGTH);
+    }
+
+    tick Elapsed = GetNanoseconds() - Start;
+    Cached = Elapsed < Cached ? Elapsed : Cached;
+
+    Start = GetNanoseconds();
+    Sink += hash::Mix(Data, BENCHMARK_LONG_LENGTH);
+    Elapsed = GetNanoseconds() - Start;
+    Whole = Elapsed < Whole ? Elapsed : Whole;
+
+    Start = GetNanoseconds();
+    hash::stream Stream = hash::Stream();
+
+    for (key Offset = 0; Offset < BENCHMARK_LONG_LENGTH; Offset += BENCHMARK_STREAM_CHUNK)
+    {
+      hash::Update(&Stream, Data + Offset, BENCHMARK_STREAM_CHUNK);
+    }
+
+    Sink += hash::Finalize(&Stream);
+    Elapsed = GetNanoseconds() - Start;
+    Streamed = Elapsed < Streamed ? Elapsed : Streamed;
+
+    Start = GetNanoseconds();
+    Sink += hash::MixTree(Data, BENCHMARK_LONG_LENGTH, ThreadCount);
+    Elapsed = GetNanoseconds() - Start;
+    Tree = Elapsed < Tree ? Elapsed : Tree;
+  }
+
+  char TreeName[64];
+  snprintf(TreeName, sizeof(TreeName), "MixTree, %u threads", ThreadCount);
+
+  fprintf(stdout, "long keys: %d MiB\n", BENCHMARK_LONG_LENGTH / MEGABYTE);
+  fprintf(stdout, "  %-28s %10s\n", "", "GB/s");
+  PrintLong("Mix, 64 KiB cached", BENCHMARK_LONG_LENGTH, Cached);
+  PrintLong("Mix", BENCHMARK_LONG_LENGTH, Whole);
+  PrintLong("stream, 4 KiB updates", BENCHMARK_LONG_LENGTH, Streamed);
+  PrintLong(TreeName, BENCHMARK_LONG_LENGTH, Tree);
+  fprintf(stdout, "\n");
+}
+
+// Stream over the leaf digests of hash::MixTree, hashed one at a time on this thread.
+hash::digest MixTreeReference(const hash::digest Seed, const char *Data, const key Length)
+{
+  hash::stream Root = hash::Stream(Seed ^ __HASH__SECRET_2);
+
+  for (key Offset = 0; Offset < Length; Offset += __HASH__TREE_LEAF_SIZE)
+  {
+    key Leaf = Length - Offset < __HASH__TREE_LEAF_SIZE ? Length - Offset : __HASH__TREE_LEAF_SIZE;
+    hash::digest Digest = hash::Mix(Seed, Data + Offset, Leaf);
+    hash::Update(&Root, &Digest, sizeof(Digest));
+  }
+
+  return hash::Finalize(&Root);
+}
+
+bool32 MatchesMix(const hash::digest Seed, const char *Data, const key Length,
+                  const u32 ThreadCount)
+{
+  static const key Chunks[] = {1, 5, 16, 47, 48, 49, 4096};
+  hash::digest Expected = hash::Mix(Seed, Data, Length);
+  hash::digest Second = hash::Mix(BENCHMARK_MATCH_SECOND_SEED, Data, Length);
+  bool32 Passed = true;
+
+  for (key Index = 0; Index < ArrayLength(Chunks); Index++)
+  {
+    hash::stream Stream = hash::Stream(Seed);
+
+    for (key Offset = 0; Offset < Length; Offset += Chunks[Index])
+    {
+      hash::Update(&Stream, Data + Offset,
+                   Length - Offset < Chunks[Index] ? Length - Offset : Chunks[Index]);
+    }
+
+    Passed = Passed && hash::Finalize(&Stream) == Expected;
+  }
+
+  const char *Strings[] = {Data};
+  const key Lengths[] = {Length};
+  hash::digest DualA, DualB, BatchA, BatchB, Batch;
+  hash::MixDual(Seed, BENCHMARK_MATCH_SECOND_SEED, Data, Length, &DualA, &DualB);
+  hash::MixBatch(Seed, Strings, Lengths, 1, &Batch);
+  hash::MixBatch(Seed, BENCHMARK_MATCH_SECOND_SEED, Strings, Lengths, 1, &BatchA, &BatchB);
+  Passed = Passed && DualA == Expected && DualB == Second;
+  Passed = Passed && Batch == Expected && BatchA == Expected && BatchB == Second;
+
+  // past one leaf the tree is its own digest, it still can't depend on the thread count
+  hash::digest Tree = hash::MixTree(Seed, Data, Length, ThreadCount);
+  Passed = Passed && hash::MixTree(Seed, Data, Length, 1) == Tree;
+  Passed = Passed && Tree == (Length <= __HASH__TREE_LEAF_SIZE
+                                  ? Expected
+                                  : MixTreeReference(Seed, Data, Length));
+
+  return Passed;
+}
+
+// Every length up to BENCHMARK_MATCH_SHORT at an aligned and an unaligned start, then lengths
+// around the leaf size of MixTree. Also covers the null terminated batch.
+bool32 RunMixMatch(const byte *Buffer, const u32 ThreadCount)
+{
+  static const key LongLengths[] = {4096 + 13, 64 * KILOBYTE, __HASH__TREE_LEAF_SIZE,
+                                    __HASH__TREE_LEAF_SIZE + 1, 3 * __HASH__TREE_LEAF_SIZE + 5};
+  static const hash::digest Seeds[] = {__HASH__DEFAULT_SEED, 0x5EED};
+  const char *Data = (const char *)Buffer;
+  bool32 Passed = true;
+
+  for (key Seed = 0; Seed < ArrayLength(Seeds); Seed++)
+  {
+    for (key Length = 0; Length <= BENCHMARK_MATCH_SHORT; Length++)
+    {
+      Passed = Passed && MatchesMix(Seeds[Seed], Data, Length, ThreadCount);
+      Passed = Passed && MatchesMix(Seeds[Seed], Data + 3, Length, ThreadCount);
+    }
+
+    for (key Index = 0; Index < ArrayLength(LongLengths); Index++)
+    {
+      Passed = Passed && MatchesMix(Seeds[Seed], Data + 1, LongLengths[Index], ThreadCount);
+    }
+  }
+
+  char Strings[BENCHMARK_MATCH_SHORT][BENCHMARK_MATCH_SHORT + 1];
+  const char *Pointers[BENCHMARK_MATCH_SHORT];
+  hash::digest Digests[BENCHMARK_MATCH_SHORT];
+
+  for (key Index = 0; Index < BENCHMARK_MATCH_SHORT; Index++)
+  {
+    for (key Byte = 0; Byte < Index; Byte++)
+    {
+      Strings[Index][Byte] = Data[Index + Byte] ? Data[Index + Byte] : 'a';
+    }
+
+    Strings[Index][Index] = 0;
+    Pointers[Index] = Strings[Index];
+  }
+
+  hash::MixBatch(Pointers, 0x0, BENCHMARK_MATCH_SHORT, Digests);
+
+  for (key Index = 0; Passed && Index < BENCHMARK_MATCH_SHORT; Index++)
+  {
+    Passed = Digests[Index] == hash::Mix(Strings[Index]);
+  }
+
+  fprintf(stdout, "Stream, MixDual, MixBatch and MixTree against Mix: %s\n\n",
+          Passed ? "ok" : "FAIL");
+
+  return Passed;
+}
+
+hash::digest AvalancheU32(const byte *Input)
+{
+  u32 Value;
+  memcpy(&Value, Input, sizeof(Value));
+  return hash::Mix(Value);
+}
+
+hash::digest AvalancheString8(const byte *Input)
+{
+  return hash::Mix((const char *)Input, 8);
+}
+
+hash::digest AvalancheString32(const byte *Input)
+{
+  return hash::Mix((const char *)Input, 32);
+}
+
+hash::digest AvalancheTable(const byte *Input)
+{
+  u64 Value;
+  memcpy(&Value, Input, sizeof(Value));
+  return hash::TableDigest(Value);
+}
+
+// Counts[Input * 64 + Output] is how often flipping input bit Input flipped output bit Output.
+avalanche_result RunAvalanche(shift_register *Random, avalanche_function Function,
+                              const key InputBits, u32 *Counts)
+{
+  byte Input[BENCHMARK_AVALANCHE_INPUT_BITS / 8];
+  key OutputOnes[64] = {};
+  memset(Counts, 0, sizeof(u32) * InputBits * 64);
+
+  for (key Sample = 0; Sample < BENCHMARK_AVALANCHE_SAMPLES; Sample++)
+  {
+    FillRandom(Random, Input, sizeof(Input));
+    hash::digest Base = Function(Input);
+
+    for (key Output = 0; Output < 64; Output++)
+    {
+      OutputOnes[Output] += (Base >> Output) & 1;
+    }
+
+    for (key Bit = 0; Bit < InputBits; Bit++)
+    {
+      Input[Bit / 8] ^= byte(1 << (Bit % 8));
+      hash::digest Flipped = Function(Input) ^ Base;
+      Input[Bit / 8] ^= byte(1 << (Bit % 8));
+
+      for (key Output = 0; Output < 64; Output++)
+      {
+        Counts[Bit * 64 + Output] += (Flipped >> Output) & 1;
+      }
+    }
+  }
+
+  avalanche_result Result = {};
+  f64 Total = 0;
+
+  for (key Bit = 0; Bit < InputBits; Bit++)
+  {
+    for (key Output = 0; Output < 64; Output++)
+    {
+      f64 Flip = f64(Counts[Bit * 64 + Output]) / BENCHMARK_AVALANCHE_SAMPLES;
+      f64 Bias = fabs(Flip - 0.5);
+      Total += Flip;
+
+      if (Bias > Result.WorstBias)
+      {
+        Result.WorstBias = Bias;
+        Result.WorstInput = Bit;
+        Result.WorstOutput = Output;
+      }
+    }
+  }
+
+  for (key Output = 0; Output < 64; Output++)
+  {
+    f64 Bias = fabs(f64(OutputOnes[Output]) / BENCHMARK_AVALANCHE_SAMPLES - 0.5);
+    Result.WorstOutputBias = Bias > Result.WorstOutputBias ? Bias : Result.WorstOutputBias;
+  }
+
+  Result.MeanFlip = Total / f64(InputBits * 64);
+  return Result;
+}
+
+// One row per input bit, one column per output bit, the darker the cell the further it is from
+// a fair coin flip.
+void PrintAvalancheMatrix(const u32 *Counts, const key InputBits)
+{
+  static const char Shades[] = " .:o#";
+
+  for (key Bit = 0; Bit < InputBits; Bit++)
+  {
+    char Row[65];
+
+    for (key Output = 0; Output < 64; Output++)
+    {
+      f64 Bias = fabs(f64(Counts[Bit * 64 + Output]) / BENCHMARK_AVALANCHE_SAMPLES - 0.5);
+      key Shade = Bias < 0.02 ? 0 : Bias < 0.05 ? 1 : Bias < 0.15 ? 2 : Bias < 0.35 ? 3 : 4;
+      Row[63 - Output] = Shades[Shade];
+    }
+
+    Row[64] = '\0';
+    fprintf(stdout, "    %3lu |%s|\n", Bit, Row);
+  }
+}
+
+bool32 RunAvalancheSuite(shift_register *Random, const bool32 PrintMatrix)
+{
+  struct avalanche_case
+  {
+    const char *Name;
+    avalanche_function Function;
+    key InputBits;
+  };
+
+  static const avalanche_case Cases[] = {
+      {"Mix(u32)", AvalancheU32, 32},
+      {"Mix, 8 bytes", AvalancheString8, 64},
+      {"Mix, 32 bytes", AvalancheString32, 256},
+      {"TableDigest(u64)", AvalancheTable, 64},
+  };
+
+  u32 *Counts = SysAllocate(u32, BENCHMARK_AVALANCHE_INPUT_BITS * 64);
+  bool32 Passed = true;
+
+  fprintf(stdout, "avalanche: %d samples, fails past %.0f%% bias\n", BENCHMARK_AVALANCHE_SAMPLES,
+          BENCHMARK_BIAS_LIMIT * 100.0);
+  fprintf(stdout, "  %-18s %10s %12s %14s %12s\n", "function", "mean flip", "worst bias",
+          "at in -> out", "output bias");
+
+  for (key Index = 0; Index < ArrayLength(Cases); Index++)
+  {
+    const avalanche_case *Case = &Cases[Index];
+    avalanche_result Result = RunAvalanche(Random, Case->Function, Case->InputBits, Counts);
+    bool32 Failed = Result.WorstBias > BENCHMARK_BIAS_LIMIT;
+    Passed = Passed && !Failed;
+
+    fprintf(stdout, "  %-18s %9.2f%% %11.2f%% %7lu -> %-4lu %11.2f%% %s\n", Case->Name,
+            Result.MeanFlip * 100.0, Result.WorstBias * 100.0, Result.WorstInput,
+            Result.WorstOutput, Result.WorstOutputBias * 100.0, Failed ? "FAIL" : "ok");
+
+    if (PrintMatrix)
+    {
+      PrintAvalancheMatrix(Counts, Case->InputBits);
+    }
+  }
+
+  SysFree(Counts);
+  fprintf(stdout, "\n");
+
+  return Passed;
+}
+
+i32 CompareDigests(const void *A, const void *B)
+{
+  hash::digest Left = *(const hash::digest *)A, Right = *(const hash::digest *)B;
+  return Left < Right ? -1 : Left > Right ? 1 : 0;
+}
+
+// Keys landing in an occupied bucket of a 2^Bits table indexed by the low bits, like the tables
+// in this repo, against what a uniform hash gives.
+void CountBuckets(const key_set *Set, const key Bits, key *Observed, f64 *Expected)
+{
+  key BucketCount = key(1) << Bits;
+  u8 *Buckets = SysAllocate(u8, BucketCount);
+  *Observed = 0;
+
+  for (key Index = 0; Index < Set->Length; Index++)
+  {
+    key Bucket = Set->Digests[Index] & (BucketCount - 1);
+    *Observed += Buckets[Bucket] ? 1 : 0;
+    Buckets[Bucket] = 1;
+  }
+
+  f64 Buckets64 = f64(BucketCount);
+  *Expected = f64(Set->Length) - Buckets64 * -expm1(f64(Set->Length) * log1p(-1.0 / Buckets64));
+  SysFree(Buckets);
+}
+
+void PrintCollisions(const key_set *Set)
+{
+  key Bits = 1;
+
+  while ((key(1) << Bits) < Set->Length * 2)
+  {
+    Bits++;
+  }
+
+  key Observed;
+  f64 Expected;
+  CountBuckets(Set, Bits, &Observed, &Expected);
+
+  qsort(Set->Digests, Set->Length, sizeof(hash::digest), CompareDigests);
+  key Full = 0, Low32 = 0;
+
+  for (key Index = 1; Index < Set->Length; Index++)
+  {
+    Full += Set->Digests[Index] == Set->Digests[Index - 1] ? 1 : 0;
+  }
+
+  for (key Index = 0; Index < Set->Length; Index++)
+  {
+    Set->Digests[Index] &= U32_MAX;
+  }
+
+  qsort(Set->Digests, Set->Length, sizeof(hash::digest), CompareDigests);
+
+  for (key Index = 1; Index < Set->Length; Index++)
+  {
+    Low32 += Set->Digests[Index] == Set->Digests[Index - 1] ? 1 : 0;
+  }
+
+  f64 ExpectedLow32 = f64(Set->Length) * f64(Set->Length - 1) / (2.0 * 4294967296.0);
+  fprintf(stdout, "  %-28s %8lu %8lu %8lu %8.1f %8lu %10.1f %4lu\n", Set->Name, Set->Length, Full,
+          Low32, ExpectedLow32, Observed, Expected, Bits);
+}
+
+// Paths shaped like the ones packed into cartridges.
+key_set CreatePathSet(shift_register *Random)
+{
+  static const char *Folders[] = {"textures", "atlas", "audio", "shaders", "levels", "fonts"};
+  static const char *Names[] = {"tile", "player", "enemy", "wall", "floor", "ui_button", "music"};
+  static const char *Extensions[] = {"tga", "wav", "glsl", "json", "crpk"};
+
+  key_set Set = {.Name = "asset paths", .Length = 0, .Digests = 0x0};
+  Set.Digests = SysAllocate(hash::digest, BENCHMARK_PATH_COUNT);
+  char Path[128];
+
+  for (key Index = 0; Index < BENCHMARK_PATH_COUNT; Index++)
+  {
+    u32 Pick = XorShiftRegisterSeed(Random);
+    snprintf(Path, sizeof(Path), "assets/%s/%s_%lu.%s", Folders[Pick % ArrayLength(Folders)],
+             Names[(Pick >> 8) % ArrayLength(Names)], Index, Extensions[(Pick >> 16) % 5]);
+    Set.Digests[Set.Length++] = hash::Mix(Path);
+  }
+
+  return Set;
+}
+
+// Common field names, then numbered and nested variants of them.
+key_set CreateFieldSet()
+{
+  static const char *Fields[] = {
+      "name", "id",    "language", "bio",   "version", "type",   "value", "x",     "y",
+      "z",    "width", "height",   "color", "data",    "items",  "count", "index", "parent",
+      "tags", "url",   "path",     "size",  "offset",  "length", "flags", "mode",  "time",
+  };
+
+  key_set Set = {.Name = "json field names", .Length = 0, .Digests = 0x0};
+  Set.Digests = SysAllocate(hash::digest, BENCHMARK_FIELD_COUNT);
+  char Field[64];
+
+  for (key Index = 0; Index < ArrayLength(Fields); Index++)
+  {
+    Set.Digests[Set.Length++] = hash::Mix(Fields[Index]);
+  }
+
+  for (key Index = 0; Set.Length < BENCHMARK_FIELD_COUNT; Index++)
+  {
+    const char *Base = Fields[Index % ArrayLength(Fields)];
+    key Number = Index / ArrayLength(Fields);
+
+    if (Index % 2)
+    {
+      snprintf(Field, sizeof(Field), "%s%lu", Base, Number);
+    }
+    else
+    {
+      snprintf(Field, sizeof(Field), "%s_%s_%lu", Fields[Number % ArrayLength(Fields)], Base,
+               Number);
+    }
+
+    Set.Digests[Set.Length++] = hash::Mix(Field);
+  }
+
+  return Set;
+}
+
+enum pair_function
+{
+  PAIR_FUNCTION_CANTOR,
+  PAIR_FUNCTION_SZUDZIK,
+};
+
+inline hash::digest Pair(const pair_function Function, const i32 X, const i32 Y)
+{
+  return Function == PAIR_FUNCTION_CANTOR ? hash::CantorPairSigned(X, Y)
+                                          : hash::SzudzikPairSigned(X, Y);
+}
+
+// Every cell of a signed grid around the origin, the pair used directly as a digest or mixed
+// through TableDigest the way hash::table would.
+key_set CreateGridSet(const char *Name, const pair_function Function, const bool32 Mixed)
+{
+  key Count = BENCHMARK_GRID_SIDE * BENCHMARK_GRID_SIDE;
+  key_set Set = {.Name = Name, .Length = 0, .Digests = SysAllocate(hash::digest, Count)};
+
+  for (i32 Y = -BENCHMARK_GRID_SIDE / 2; Y < BENCHMARK_GRID_SIDE / 2; Y++)
+  {
+    for (i32 X = -BENCHMARK_GRID_SIDE / 2; X < BENCHMARK_GRID_SIDE / 2; X++)
+    {
+      hash::digest Digest = Pair(Function, X, Y);
+      Set.Digests[Set.Length++] = Mixed ? hash::TableDigest(Digest) : Digest;
+    }
+  }
+
+  return Set;
+}
+
+// Coordinates scattered over a few million units, far enough out for the pairs to overflow.
+key_set CreateWideGridSet(shift_register *Random, const char *Name, const pair_function Function)
+{
+  key_set Set = {.Name = Name, .Length = 0, .Digests = 0x0};
+  Set.Digests = SysAllocate(hash::digest, BENCHMARK_WIDE_GRID_COUNT);
+
+  while (Set.Length < BENCHMARK_WIDE_GRID_COUNT)
+  {
+    i32 X = i32(XorShiftRegisterSeed(Random) % (1 << 22)) - (1 << 21);
+    i32 Y = i32(XorShiftRegisterSeed(Random) % (1 << 22)) - (1 << 21);
+    Set.Digests[Set.Length++] = Pair(Function, X, Y);
+  }
+
+  return Set;
+}
+
+void RunCollisions(shift_register *Random)
+{
+  key_set Sets[] = {
+      CreatePathSet(Random),
+      CreateFieldSet(),
+      CreateGridSet("cantor grid", PAIR_FUNCTION_CANTOR, false),
+      CreateGridSet("cantor grid, TableDigest", PAIR_FUNCTION_CANTOR, true),
+      CreateGridSet("szudzik grid", PAIR_FUNCTION_SZUDZIK, false),
+      CreateGridSet("szudzik grid, TableDigest", PAIR_FUNCTION_SZUDZIK, true),
+      CreateWideGridSet(Random, "cantor wide grid", PAIR_FUNCTION_CANTOR),
+      CreateWideGridSet(Random, "szudzik wide grid", PAIR_FUNCTION_SZUDZIK),
+  };
+
+  fprintf(stdout, "collisions: full digest, low 32 bits and low bits buckets of a 2^n table\n");
+  fprintf(stdout, "  %-28s %8s %8s %8s %8s %8s %10s %4s\n", "set", "keys", "64 bit", "32 bit",
+          "expected", "buckets", "expected", "n");
+
+  for (key Index = 0; Index < ArrayLength(Sets); Index++)
+  {
+    PrintCollisions(&Sets[Index]);
+    SysFree(Sets[Index].Digests);
+  }
+
+  fprintf(stdout, "\n");
+}
+
+// Random u64 keys, the lookups hit in shuffled order.
+void RunTable(shift_register *Random)
+{
+  allocator::slab *Slab = allocator::CreateSlab();
+  u64 *Keys = SysAllocate(u64, BENCHMARK_TABLE_KEYS);
+
+  for (key Index = 0; Index < BENCHMARK_TABLE_KEYS; Index++)
+  {
+    Keys[Index] = Random64(Random);
+  }
+
+  hash::table<u64, u64, allocator::slab> Table = hash::Table<u64, u64>(Slab, 0);
+
+  tick Start = GetNanoseconds();
+
+  for (key Index = 0; Index < BENCHMARK_TABLE_KEYS; Index++)
+  {
+    hash::Insert(&Table, Keys[Index], u64(Index));
+  }
+
+  tick Inserted = GetNanoseconds() - Start;
+
+  for (key Index = BENCHMARK_TABLE_KEYS - 1; Index > 0; Index--)
+  {
+    key Other = XorShiftRegisterSeed(Random) % (Index + 1);
+    u64 Swap = Keys[Index];
+    Keys[Index] = Keys[Other];
+    Keys[Other] = Swap;
+  }
+
+  Start = GetNanoseconds();
+
+  for (key Index = 0; Index < BENCHMARK_TABLE_KEYS; Index++)
+  {
+    Sink += *hash::Find(&Table, Keys[Index]);
+  }
+
+  tick Found = GetNanoseconds() - Start;
+  Start = GetNanoseconds();
+
+  for (key Index = 0; Index < BENCHMARK_TABLE_KEYS; Index++)
+  {
+    Sink += hash::Find(&Table, Keys[Index] ^ 1) ? 1 : 0;
+  }
+
+  tick Missed = GetNanoseconds() - Start;
+
+  fprintf(stdout, "hash::table: %d u64 keys, capacity %lu\n", BENCHMARK_TABLE_KEYS,
+          Table.Capacity);
+  fprintf(stdout, "  %-8s %10.2f ns/op\n", "insert", f64(Inserted) / BENCHMARK_TABLE_KEYS);
+  fprintf(stdout, "  %-8s %10.2f ns/op\n", "hit", f64(Found) / BENCHMARK_TABLE_KEYS);
+  fprintf(stdout, "  %-8s %10.2f ns/op\n", "miss", f64(Missed) / BENCHMARK_TABLE_KEYS);
+  fprintf(stdout, "\n");
+
+  hash::Destroy(&Table);
+  allocator::Destroy(Slab);
+  SysFree(Keys);
+}
+
+// Slab that counts the blocks a table asks for, each one is a rehash.
+struct counting_allocator
+{
+  allocator::slab *Slab;
+  key Allocations;
+};
+
+void *_Allocate(counting_allocator *Allocator, const key Align, const key Size)
+{
+  Allocator->Allocations++;
+  return allocator::_Allocate(Allocator->Slab, Align, Size);
+}
+
+void Free(counting_allocator *Allocator, void *Memory)
+{
+  allocator::Free(Allocator->Slab, Memory);
+}
+
+typedef hash::table<u64, u64, counting_allocator> check_table;
+
+inline u64 CheckKey(const key Index)
+{
+  // spread over the whole range so the keys don't simply count up
+  return u64(Index) * 0x9E3779B97F4A7C15ull;
+}
+
+bool32 CheckTableContents(const check_table *Table, const bool32 *Present, const u64 *Values,
+                          const key Count)
+{
+  key Live = 0;
+
+  for (key Index = 0; Index < BENCHMARK_CHECK_KEYS; Index++)
+  {
+    const u64 *Value = hash::Find(Table, CheckKey(Index));
+
+    if (Present[Index] ? !Value || *Value != Values[Index] : Value != 0x0)
+    {
+      return false;
+    }
+
+    Live += Present[Index] ? 1 : 0;
+  }
+
+  return Live == Count && Table->Count == Count;
+}
+
+// Random inserts, removes and lookups against a plain array of the same keys. Phases alternate
+// between mostly inserting and mostly removing so the table goes through growth, tombstones
+// piling up and tombstones being cleared in place.
+bool32 RunTableOperations(shift_register *Random, counting_allocator *Allocator)
+{
+  check_table Table = hash::Table<u64, u64>(Allocator, 0);
+  bool32 *Present = SysAllocate(bool32, BENCHMARK_CHECK_KEYS);
+  u64 *Values = SysAllocate(u64, BENCHMARK_CHECK_KEYS);
+  key Count = 0;
+  bool32 Passed = true;
+
+  for (key Phase = 0; Passed && Phase < BENCHMARK_CHECK_PHASES; Phase++)
+  {
+    u32 InsertOdds = Phase % 2 ? 3 : 13;
+
+    for (key Operation = 0; Passed && Operation < BENCHMARK_CHECK_PHASE; Operation++)
+    {
+      u32 Pick = XorShiftRegisterSeed(Random);
+      key Index = (Pick >> 4) % BENCHMARK_CHECK_KEYS;
+      u64 Key = CheckKey(Index);
+
+      if (Pick % 16 < InsertOdds)
+      {
+        bool32 Inserted;
+        u64 *Value = hash::Insert(&Table, Key, &Inserted);
+        Passed = Value && Inserted == !Present[Index] && (Inserted || *Value == Values[Index]);
+
+        if (Passed)
+        {
+          *Value = Values[Index] = Random64(Random);
+          Count += Present[Index] ? 0 : 1;
+          Present[Index] = true;
+        }
+      }
+      else if (Pick % 16 < 15)
+      {
+        Passed = hash::Remove(&Table, Key) == Present[Index] && !hash::Find(&Table, Key);
+        Count -= Present[Index] ? 1 : 0;
+        Present[Index] = false;
+      }
+      else
+      {
+        const u64 *Value = hash::Find(&Table, Key);
+        Passed = Present[Index] ? Value && *Value == Values[Index] : !Value;
+      }
+    }
+
+    Passed = Passed && CheckTableContents(&Table, Present, Values, Count);
+  }
+
+  hash::Destroy(&Table);
+  SysFree(Present);
+  SysFree(Values);
+
+  return Passed;
+}
+
+// One entry under the max load of a fixed capacity, then a remove and an insert of a new key at a
+// time. Returns the number of rehashes, the table should grow once and then stay put.
+key RunTableChurn(shift_register *Random, counting_allocator *Allocator, bool32 *Passed)
+{
+  key Live = hash::TableMaxLoad(BENCHMARK_CHURN_CAPACITY) - 1;
+  check_table Table = hash::Table<u64, u64>(Allocator, 0);
+  u64 *Keys = SysAllocate(u64, Live);
+  key Next = 0;
+
+  for (; Next < Live; Next++)
+  {
+    Keys[Next] = CheckKey(Next);
+    hash::Insert(&Table, Keys[Next], Keys[Next] ^ 1);
+  }
+
+  *Passed = Table.Capacity == BENCHMARK_CHURN_CAPACITY;
+  key Allocations = Allocator->Allocations;
+
+  for (key Pair = 0; *Passed && Pair < BENCHMARK_CHURN_PAIRS; Pair++, Next++)
+  {
+    key Index = XorShiftRegisterSeed(Random) % Live;
+    *Passed = hash::Remove(&Table, Keys[Index]) && !hash::Find(&Table, Keys[Index]);
+
+    Keys[Index] = CheckKey(Next);
+    u64 *Value = hash::Insert(&Table, Keys[Index], Keys[Index] ^ 1);
+    *Passed = *Passed && Value && *Value == (Keys[Index] ^ 1);
+  }
+
+  for (key Index = 0; *Passed && Index < Live; Index++)
+  {
+    const u64 *Value = hash::Find(&Table, Keys[Index]);
+    *Passed = Value && *Value == (Keys[Index] ^ 1);
+  }
+
+  *Passed = *Passed && Table.Count == Live;
+  Allocations = Allocator->Allocations - Allocations;
+
+  hash::Destroy(&Table);
+  SysFree(Keys);
+
+  return Allocations;
+}
+
+// Build with -U__SSE2__ to check the SWAR group matching, compile.sh builds both.
+bool32 RunTableCheck(shift_register *Random)
+{
+  counting_allocator Allocator = {.Slab = allocator::CreateSlab(), .Allocations = 0};
+
+  bool32 OperationsPassed = RunTableOperations(Random, &Allocator);
+  bool32 ChurnPassed;
+  key Rehashes = RunTableChurn(Random, &Allocator, &ChurnPassed);
+  ChurnPassed = ChurnPassed && Rehashes <= 1;
+
+  fprintf(stdout, "hash::table check: groups of %d\n", __TABLE__GROUP_WIDTH);
+  fprintf(stdout, "  %-40s %s\n", "insert, remove and find against an array",
+          OperationsPassed ? "ok" : "FAIL");
+  fprintf(stdout, "  %-40s %s, %lu rehashes in %d pairs\n", "remove and insert at max load",
+          ChurnPassed ? "ok" : "FAIL", Rehashes, BENCHMARK_CHURN_PAIRS);
+  fprintf(stdout, "\n");
+
+  allocator::Destroy(Allocator.Slab);
+
+  return OperationsPassed && ChurnPassed;
+}
+
+// Pass -m to print the full avalanche matrices. Exits with 1 when a variant of Mix disagrees with
+// it, or an avalanche or table check fails.
+i32 main(i32 Argc, const char *Argv[])
+{
+  shift_register Random = {.Seed = 0x2545F491};
+  bool32 PrintMatrix = Argc > 1 && !strcmp(Argv[1], "-m");
+  u32 ThreadCount = u32(sysconf(_SC_NPROCESSORS_ONLN));
+
+  byte *Buffer = SysAllocate(byte, BENCHMARK_LONG_LENGTH);
+
+  if (!Buffer)
+  {
+    fprintf(stdout, "Failed to allocate the benchmark buffer.\n");
+    return 1;
+  }
+
+  FillRandom(&Random, Buffer, BENCHMARK_LONG_LENGTH);
+
+  RunShortKeys(Buffer);
+  RunLongKeys(Buffer, ThreadCount ? ThreadCount : 1);
+  bool32 Passed = RunMixMatch(Buffer, ThreadCount ? ThreadCount : 1);
+  Passed = RunAvalancheSuite(&Random, PrintMatrix) && Passed;
+  RunCollisions(&Random);
+  Passed = RunTableCheck(&Random) && Passed;
+  RunTable(&Random);
+
+  SysFree(Buffer);
+
+  return Passed ? 0 : 1;
+}
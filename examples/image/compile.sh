@@ -5,7 +5,11 @@ cd $(dirname $0)/../..
 
 mkdir -p build
 
-clang++ -std=c++14 -o build/image_d -Iinclude -Wall -lX11 -lGL -g \
-  examples/image/main.cc                                          \
-  include/shader_opengl.cc                                        \
+clang++ -std=c++14 -o build/image_d -Iinclude -Wall -lX11 -lGL -lpthread -g \
+  examples/image/main.cc                                                    \
+  include/allocators/chained.cc                                             \
+  include/allocators/scratch.cc                                             \
+  include/allocators/virtual_bump.cc                                        \
+  include/buffer.cc                                                         \
+  include/shader_opengl.cc                                                  \
   include/tga.cc
@@ -17,7 +17,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include <common.hh>
+#include <allocators/chained.hh>
+#include <allocators/scratch.hh>
 #include <atlas.hh>
+#include <buffer.hh>
 #include <math2d.hh>
 #include <shader.hh>
 #include <texture.hh>
@@ -34,6 +37,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 // glibc
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // gl variables
 const GLchar *VERTEX_SHADER = R"(
@@ -186,8 +190,91 @@ i32 HandleX11Error(Display *XDisplay, XErrorEvent *XError)
   return 0;
 }
 
+template <typename A> struct texture_load
+{
+  A *Allocator;
+  const texture **Textures;
+  bool32 Failed;
+};
+
+// decodes each TGA as soon as it is read, while the other files are still loading
+template <typename A> void DecodeTexture(void *User, const key Index, const buffer Buffer)
+{
+  texture_load<A> *Load = (texture_load<A> *)User;
+
+  if (!IsInitialized(Buffer))
+  {
+    fprintf(stdout, "Failed to read TGA file.\n");
+    Load->Failed = true;
+    return;
+  }
+
+  Load->Textures[Index] = tga::Decompress(Load->Allocator, Buffer.Length, Buffer.Data);
+  FreeBuffer(Buffer);
+
+  if (Load->Textures[Index] == 0x0)
+  {
+    fprintf(stdout, "Failed to parse TGA file.\n");
+    Load->Failed = true;
+  }
+}
+
+template <typename A>
+bool32 LoadTextures(A *Allocator, const key Count, const char **Paths, const texture **Textures)
+{
+  texture_load<A> Load = {.Allocator = Allocator, .Textures = Textures, .Failed = false};
+  buffer *TGABuffers = SysAllocate(buffer, Count);
+  LoadBuffersFromFiles(Count, Paths, TGABuffers, DecodeTexture<A>, &Load);
+  SysFree(TGABuffers);
+
+  return !Load.Failed;
+}
+
+// Saves the texture as an uncompressed 32 bit TGA, rows in the order they were decoded. The header
+// is staged by the writer while the pixels go out from their own memory in the same writev.
+bool32 WriteTexture(const texture *Texture, const char *Path)
+{
+  byte Header[18] = {};
+  Header[2] = 2; // uncompressed true color
+  Header[12] = byte(Texture->Width);
+  Header[13] = byte(Texture->Width >> 8);
+  Header[14] = byte(Texture->Height);
+  Header[15] = byte(Texture->Height >> 8);
+  Header[16] = 32;
+  Header[17] = 8; // alpha bits
+
+  key PixelCount = Texture->Width * Texture->Height;
+  pixel *Pixels = SysAllocate(pixel, PixelCount);
+
+  for (key Index = 0; Index < PixelCount; Index++)
+  {
+    pixel Pixel = Texture->Pixels[Index];
+    Pixels[Index] = {.R = Pixel.B, .G = Pixel.G, .B = Pixel.R, .A = Pixel.A};
+  }
+
+  buffer Buffers[2] = {
+      {.Length = sizeof(Header), .Data = Header},
+      {.Length = sizeof(pixel) * PixelCount, .Data = Pixels},
+  };
+
+  bool32 Result = WriteFileFromBuffers(2, Buffers, Path);
+  SysFree(Pixels);
+
+  return Result;
+}
+
+// -o Path saves the displayed texture, the atlas when several TGAs are given
 i32 main(i32 Argc, char *Argv[])
 {
+  const char *OutputPath = 0x0;
+
+  if (Argc > 2 && !strcmp(Argv[1], "-o"))
+  {
+    OutputPath = Argv[2];
+    Argv += 2;
+    Argc -= 2;
+  }
+
   if (Argc < 2)
   {
     fprintf(stdout, "TGA file argument is required to render image.\n");
@@ -198,53 +285,47 @@ i32 main(i32 Argc, char *Argv[])
 
   const texture *Textures[1024];
 
-  for (key Index = 0; Index < TextureCount; Index++)
-  {
-    FILE *File = fopen(Argv[Index + 1], "r");
-    key TGALength = 0;
-    void *TGAData = 0x0;
+  // what is displayed lives in one arena, released on exit
+  allocator::chained *LevelAllocator = allocator::CreateChained(16 * MEGABYTE);
+  const texture *DisplayTexture;
 
-    if (File)
-    {
-      fseek(File, 0, SEEK_END);
-      TGALength = ftell(File);
-      TGAData = SysAllocate(byte, TGALength);
-      rewind(File);
-      fread(TGAData, 1, TGALength, File);
+  if (TextureCount > 1)
+  {
+    // Decoded textures are only staging for the atlas. They go to the thread's scratch arena,
+    // which commits as much as the TGAs need and is rolled back once the atlas holds a copy.
+    allocator::scratch Scratch;
 
-      fclose(File);
-    }
-    else
+    if (!LoadTextures(Scratch.Allocator, TextureCount, (const char **)&Argv[1], Textures))
     {
-      fprintf(stdout, "Failed to read TGA file.\n");
       return 1;
     }
 
-    Textures[Index] = tga::Decompress(TGALength, TGAData);
+    const atlas::pack *Atlas = atlas::CreateAtlas(LevelAllocator, TextureCount, Textures);
 
-    if (Textures[Index] == 0x0)
+    for (key Index = 0; Index < Atlas->Size; Index++)
     {
-      fprintf(stdout, "Failed to parse TGA file.\n");
-      return 1;
+      atlas::coordinates *Coordinates = Atlas->Coordinates + Index;
+      fprintf(stdout, "Coordinates Start.X: %f, Start.Y: %f, End.X: %f, End.Y: %f.\n",
+              Coordinates->Start.X, Coordinates->Start.Y, Coordinates->End.X, Coordinates->End.Y);
     }
 
-    free(TGAData);
+    DisplayTexture = Atlas->Texture;
   }
-
-  const atlas::pack *Atlas;
-  if (TextureCount > 1)
+  else
   {
-    Atlas = atlas::CreateAtlas(TextureCount, Textures);
-
-    for (key Index = 0; Index < Atlas->Size; Index++)
+    if (!LoadTextures(LevelAllocator, TextureCount, (const char **)&Argv[1], Textures))
     {
-      atlas::coordinates *Coordinates = Atlas->Coordinates + Index;
-      fprintf(stdout, "Coordinates Start.X: %f, Start.Y: %f, End.X: %f, End.Y: %f.\n",
-              Coordinates->Start.X, Coordinates->Start.Y, Coordinates->End.X, Coordinates->End.Y);
+      return 1;
     }
+
+    DisplayTexture = Textures[0];
   }
 
-  const texture *DisplayTexture = TextureCount > 1 ? Atlas->Texture : Textures[0];
+  if (OutputPath && !WriteTexture(DisplayTexture, OutputPath))
+  {
+    fprintf(stdout, "Failed to write '%s'.\n", OutputPath);
+    return 1;
+  }
 
   // x11 state initialization
   fprintf(stdout, "Initializing x11 platform.\n");
@@ -390,5 +471,7 @@ i32 main(i32 Argc, char *Argv[])
   glDeleteTextures(1, &TextureId);
   glDeleteProgram(ShaderId);
 
+  allocator::Destroy(LevelAllocator);
+
   return 0;
 }
@@ -16,15 +16,36 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
-#include <allocators/bump.hh>
-#include <allocators/fake.hh>
+#include <allocators/chained.hh>
 #include <buffer.hh>
 #include <common.hh>
 #include <hash.hh>
+#include <hash_table.hh>
 #include <math2d.hh>
 
 #include <cstdio>
 
+#define JSON_ALLOCATOR_BLOCK_SIZE (64 * KILOBYTE)
+
+// Object field tables hold on to the allocator they were built from, behind a function pointer
+// so the parser stays generic over the allocator type.
+struct json_allocator
+{
+  void *Allocator;
+  void *(*Function)(void *Allocator, const key Align, const key Size);
+};
+
+inline void *_Allocate(json_allocator *Allocator, const key Align, const key Size)
+{
+  return Allocator->Function(Allocator->Allocator, Align, Size);
+}
+
+template <typename A> void *JsonAllocate(void *Allocator, const key Align, const key Size)
+{
+  // unqualified so the allocator's own _Allocate is found by argument dependent lookup
+  return _Allocate((A *)Allocator, Align, Size);
+}
+
 struct json_raw_string
 {
   const key Length;
@@ -63,17 +84,11 @@ struct json_value_header
   json_value Value;
 };
 
-struct json_object_slot
-{
-  hash::digest Hash;
-  json_value_header Header;
-};
-
+// fields are keyed by the digest of their name, the table points to Allocator
 struct json_object
 {
-  key Capacity;
-  key Count;
-  json_object_slot *Slots;
+  json_allocator Allocator;
+  hash::table<hash::digest, json_value_header, json_allocator> Fields;
 };
 
 struct input_reader
@@ -582,38 +597,21 @@ template <typename A> json_array *ParseArray(A *Allocator, input_reader *Reader)
   return Result;
 }
 
-inline json_object_slot *GetSlot(const json_object *JsonObject, const hash::digest Hash)
+inline json_value_header *GetField(const json_object *JsonObject, const hash::digest Hash)
 {
-  key Index = Hash % JsonObject->Capacity;
-  key Attempts = 0;
-
-  json_object_slot *Slot = &JsonObject->Slots[Index];
-
-  while (Slot->Hash != Hash)
-  {
-    Assert(Attempts < JsonObject->Capacity, "Could not acquire slot in JsonObject hashmap.");
-    Attempts++;
-    Index = (Index + 1) % JsonObject->Capacity;
-    Slot = &JsonObject->Slots[Index];
-  }
+  json_value_header *Field = hash::Find(&JsonObject->Fields, Hash);
+  Assert(Field, "Json field was not found in object.");
 
-  return Slot;
+  return Field;
 }
 
-inline json_object_slot *AssignEmptySlot(const json_object *JsonObject,
-                                         const json_raw_string *RawString)
+// a repeated field name keeps the last value
+inline json_value_header *AssignField(json_object *JsonObject, const json_raw_string *RawString)
 {
+  bool32 Inserted;
   hash::digest Hash = hash::Mix(RawString->String, RawString->Length);
-  json_object_slot *Slot = GetSlot(JsonObject, 0);
-  Slot->Hash = Hash;
-
-  return Slot;
-}
 
-inline json_object_slot *GetSlot(const json_object *JsonObject, const char *StringKey)
-{
-  hash::digest Hash = hash::Mix(StringKey);
-  return GetSlot(JsonObject, Hash);
+  return hash::Insert(&JsonObject->Fields, Hash, &Inserted);
 }
 
 template <typename A> json_object *ParseObject(A *Allocator, input_reader *Reader)
@@ -666,17 +664,15 @@ template <typename A> json_object *ParseObject(A *Allocator, input_reader *Reade
 
   FirstLoop = true;
   json_object *Result = Allocate(Allocator, json_object);
-  key Capacity = f32(ObjectCount) * 1.5f;
 
   if (Result)
   {
-    Result->Count = ObjectCount;
-    Result->Capacity = Capacity; // Reduce risk of collisions
-    Result->Slots = AllocateN(Allocator, json_object_slot, Capacity);
+    // sized up front so parsing the fields never grows it
+    Result->Allocator = {.Allocator = Allocator, .Function = JsonAllocate<A>};
+    Result->Fields = hash::Table<hash::digest, json_value_header>(&Result->Allocator, ObjectCount);
   }
   else
   {
-    AllocateN(Allocator, json_object_slot, Capacity);
     SetFlag(&Reader->Error, INPUT_READER_ERROR_ALLOCATION);
   }
 
@@ -699,10 +695,11 @@ template <typename A> json_object *ParseObject(A *Allocator, input_reader *Reade
 
     Accept(Reader, ':');
 
-    if (Result && Result->Slots)
+    json_value_header *Field = Result ? AssignField(Result, &RawString) : 0x0;
+
+    if (Field)
     {
-      json_object_slot *Slot = AssignEmptySlot(Result, &RawString);
-      Slot->Header = ParseValue(Allocator, Reader);
+      *Field = ParseValue(Allocator, Reader);
     }
     else
     {
@@ -721,58 +718,93 @@ template <typename A> json_object *ParseObject(A *Allocator, input_reader *Reade
   return Result;
 }
 
+json_value_header *JsonGetValue(const json_object *Object, const hash::digest FieldHash)
+{
+  return GetField(Object, FieldHash);
+}
+
+f32 JsonGetNumber(const json_object *Object, const hash::digest FieldHash)
+{
+  json_value_header *Field = GetField(Object, FieldHash);
+  Assert(Field->Type == JSON_VALUE_TYPE_NUMBER, "Json field was not a number.");
+
+  return Field->Value.Number;
+}
+
+bool32 JsonGetBoolean(const json_object *Object, const hash::digest FieldHash)
+{
+  json_value_header *Field = GetField(Object, FieldHash);
+  Assert(Field->Type == JSON_VALUE_TYPE_BOOLEAN, "Json field was not a boolean.");
+
+  return Field->Value.Boolean;
+}
+
+bool32 JsonGetNull(const json_object *Object, const hash::digest FieldHash)
+{
+  json_value_header *Field = GetField(Object, FieldHash);
+  Assert(Field->Type == JSON_VALUE_TYPE_NULL, "Json field was not a null value.");
+
+  return Field->Value.Null;
+}
+
+json_string *JsonGetString(const json_object *Object, const hash::digest FieldHash)
+{
+  json_value_header *Field = GetField(Object, FieldHash);
+  Assert(Field->Type == JSON_VALUE_TYPE_STRING, "Json field was not a string.");
+
+  return Field->Value.String;
+}
+
+json_array *JsonGetArray(const json_object *Object, const hash::digest FieldHash)
+{
+  json_value_header *Field = GetField(Object, FieldHash);
+  Assert(Field->Type == JSON_VALUE_TYPE_ARRAY, "Json field was not an array.");
+
+  return Field->Value.Array;
+}
+
+json_object *JsonGetObject(const json_object *Object, const hash::digest FieldHash)
+{
+  json_value_header *Field = GetField(Object, FieldHash);
+  Assert(Field->Type == JSON_VALUE_TYPE_OBJECT, "Json field was not an object.");
+
+  return Field->Value.Object;
+}
+
+// names hashed on every call, HashKey("name") takes the hashing out of hot lookups
 json_value_header *JsonGetValue(const json_object *Object, const char *FieldName)
 {
-  json_object_slot *Slot = GetSlot(Object, FieldName);
-  return &Slot->Header;
+  return JsonGetValue(Object, hash::Mix(FieldName));
 }
 
 f32 JsonGetNumber(const json_object *Object, const char *FieldName)
 {
-  json_object_slot *Slot = GetSlot(Object, FieldName);
-  Assert(Slot->Header.Type == JSON_VALUE_TYPE_NUMBER, "Json field was not a number.");
-
-  return Slot->Header.Value.Number;
+  return JsonGetNumber(Object, hash::Mix(FieldName));
 }
 
 bool32 JsonGetBoolean(const json_object *Object, const char *FieldName)
 {
-  json_object_slot *Slot = GetSlot(Object, FieldName);
-  Assert(Slot->Header.Type == JSON_VALUE_TYPE_BOOLEAN, "Json field was not a boolean.");
-
-  return Slot->Header.Value.Boolean;
+  return JsonGetBoolean(Object, hash::Mix(FieldName));
 }
 
 bool32 JsonGetNull(const json_object *Object, const char *FieldName)
 {
-  json_object_slot *Slot = GetSlot(Object, FieldName);
-  Assert(Slot->Header.Type == JSON_VALUE_TYPE_NULL, "Json field was not a null value.");
-
-  return Slot->Header.Value.Null;
+  return JsonGetNull(Object, hash::Mix(FieldName));
 }
 
 json_string *JsonGetString(const json_object *Object, const char *FieldName)
 {
-  json_object_slot *Slot = GetSlot(Object, FieldName);
-  Assert(Slot->Header.Type == JSON_VALUE_TYPE_STRING, "Json field was not a string.");
-
-  return Slot->Header.Value.String;
+  return JsonGetString(Object, hash::Mix(FieldName));
 }
 
 json_array *JsonGetArray(const json_object *Object, const char *FieldName)
 {
-  json_object_slot *Slot = GetSlot(Object, FieldName);
-  Assert(Slot->Header.Type == JSON_VALUE_TYPE_ARRAY, "Json field was not an array.");
-
-  return Slot->Header.Value.Array;
+  return JsonGetArray(Object, hash::Mix(FieldName));
 }
 
 json_object *JsonGetObject(const json_object *Object, const char *FieldName)
 {
-  json_object_slot *Slot = GetSlot(Object, FieldName);
-  Assert(Slot->Header.Type == JSON_VALUE_TYPE_OBJECT, "Json field was not a number.");
-
-  return Slot->Header.Value.Object;
+  return JsonGetObject(Object, hash::Mix(FieldName));
 }
 
 inline json_value_header *JsonArrayGet(const json_array *Array, const key Index)
@@ -829,7 +861,7 @@ json_array *JsonGetArray(const json_array *Array, const key Index)
 json_object *JsonGetObject(const json_array *Array, const key Index)
 {
   json_value_header *Header = JsonArrayGet(Array, Index);
-  Assert(Header->Type == JSON_VALUE_TYPE_OBJECT, "Json field was not a number.");
+  Assert(Header->Type == JSON_VALUE_TYPE_OBJECT, "Json field was not an object.");
 
   return Header->Value.Object;
 }
@@ -863,31 +895,18 @@ i32 main(const i32 Argc, const char *Argv[])
     return 1;
   }
 
-  allocator::fake *FakeAllocator = allocator::CreateFake();
-
-  JsonParse(FakeAllocator, &Reader);
-  const key AllocationSize = allocator::MemoryUsed(FakeAllocator);
-
-  allocator::Destroy(FakeAllocator);
-
-  if (HasFlag(Reader.Error, INPUT_READER_ERROR_PARSING))
-  {
-    printf("Failed to parse json object.\n");
-    return 1;
-  }
-
-  Reader.Offset = 0;
-  Reader.Error = 0;
-  allocator::bump *Allocator = allocator::CreateBump(AllocationSize);
+  allocator::chained *Allocator = allocator::CreateChained(JSON_ALLOCATOR_BLOCK_SIZE);
   json_value_header Root = JsonParse(Allocator, &Reader);
 
   if (Reader.Error == INPUT_READER_ERROR_NONE)
   {
     json_object *FourthEntry = JsonGetObject(Root.Value.Array, 3);
     printf("Fourth entry name is: %s, language: %s, id: %s, bio: %s, version: %f\n",
-           JsonGetString(FourthEntry, "name")->Buffer,
-           JsonGetString(FourthEntry, "language")->Buffer, JsonGetString(FourthEntry, "id")->Buffer,
-           JsonGetString(FourthEntry, "bio")->Buffer, JsonGetNumber(FourthEntry, "version"));
+           JsonGetString(FourthEntry, HashKey("name"))->Buffer,
+           JsonGetString(FourthEntry, HashKey("language"))->Buffer,
+           JsonGetString(FourthEntry, HashKey("id"))->Buffer,
+           JsonGetString(FourthEntry, HashKey("bio"))->Buffer,
+           JsonGetNumber(FourthEntry, HashKey("version")));
     printf("Entry count for array is: %lu\n", Root.Value.Array->Length);
   }
   else
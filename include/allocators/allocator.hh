@@ -20,12 +20,20 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <common.hh>
 
-#define Allocate(_Block, _Type) (_Type *)allocator::_Allocate(_Block, alignof(_Type), sizeof(_Type))
+// Unqualified so templated callers find the allocator::_Allocate overload by argument dependent
+// lookup, whether or not its header was included before the template was defined.
+#define Allocate(_Block, _Type) (_Type *)_Allocate(_Block, alignof(_Type), sizeof(_Type))
 #define AllocateN(_Block, _Type, _Length)                                                          \
-  (_Type *)allocator::_Allocate(_Block, alignof(_Type), sizeof(_Type) * _Length)
+  (_Type *)_Allocate(_Block, alignof(_Type), sizeof(_Type) * _Length)
 
 inline key_diff GetPadding(const void *Offset, const key Align)
 {
   // align padding by power of two
   return -(key_diff)Offset & (Align - 1);
 }
+
+inline key AlignUp(const key Value, const key Align)
+{
+  // round up to a power of two
+  return (Value + Align - 1) & ~(Align - 1);
+}
@@ -0,0 +1,80 @@
+/*
+Atomic bump allocator implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "atomic_bump.hh"
+
+// Offset is always kept a multiple of this so common alignments never need padding
+#define __ATOMIC_BUMP__GRANULE sizeof(void *)
+
+allocator::atomic_bump *allocator::CreateAtomicBump(const key Size)
+{
+  key HeaderSize = sizeof(allocator::atomic_bump);
+  byte *RawMemory = SysAllocate(byte, Size + HeaderSize);
+
+  if (!RawMemory)
+  {
+    return 0x0;
+  }
+
+  allocator::atomic_bump *Output = (allocator::atomic_bump *)RawMemory;
+  Output->Begin = RawMemory + HeaderSize;
+  Output->End = Output->Begin + Size;
+  Output->Offset = 0;
+
+  return Output;
+}
+
+void *allocator::_Allocate(allocator::atomic_bump *Allocator, const key Align, const key Size)
+{
+  if (Size == 0)
+  {
+    return 0x0;
+  }
+
+  key Granule = __ATOMIC_BUMP__GRANULE;
+  key Reserve = (Size + Granule - 1) & ~(Granule - 1);
+
+  // reserve the worst case padding up front so a single fetch-add is enough
+  if (Align > Granule)
+  {
+    Reserve += Align - Granule;
+  }
+
+  key Offset = __atomic_fetch_add(&Allocator->Offset, Reserve, __ATOMIC_RELAXED);
+  byte *Output = Allocator->Begin + Offset;
+  Output += GetPadding(Output, Align);
+
+  Assert(Output + Size <= Allocator->End, "Allocator overflow.");
+
+  return Output;
+}
+
+void allocator::Reset(allocator::atomic_bump *Allocator)
+{
+  __atomic_store_n(&Allocator->Offset, 0, __ATOMIC_RELEASE);
+}
+
+void allocator::Destroy(allocator::atomic_bump *Allocator)
+{
+  SysFree(Allocator);
+}
+
+key allocator::MemoryUsed(allocator::atomic_bump *Allocator)
+{
+  return __atomic_load_n(&Allocator->Offset, __ATOMIC_ACQUIRE);
+}
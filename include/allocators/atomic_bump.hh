@@ -0,0 +1,46 @@
+/*
+Atomic bump allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "../common.hh"
+
+#define __ATOMIC_BUMP__CACHE_LINE 64
+
+namespace allocator
+{
+// Bump allocator that can be shared between threads, _Allocate is a single fetch-add for any
+// alignment up to sizeof(void *). Reset and Destroy must not race with _Allocate.
+struct atomic_bump
+{
+  byte *Begin;
+  byte *End;
+
+  // padded to its own cache line so readers of Begin/End and the data don't bounce with writers
+  byte BeginPadding[__ATOMIC_BUMP__CACHE_LINE - sizeof(byte *) * 2];
+  key Offset;
+  byte EndPadding[__ATOMIC_BUMP__CACHE_LINE - sizeof(key)];
+};
+
+void *_Allocate(allocator::atomic_bump *Allocator, const key Align, const key Size);
+allocator::atomic_bump *CreateAtomicBump(const key Size);
+void Reset(allocator::atomic_bump *Allocator);
+void Destroy(allocator::atomic_bump *Allocator);
+key MemoryUsed(allocator::atomic_bump *Allocator);
+}; // namespace allocator
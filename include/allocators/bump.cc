@@ -22,11 +22,16 @@ allocator::bump *allocator::CreateBump(const key Size)
 {
   key HeaderSize = sizeof(allocator::bump);
   byte *RawMemory = SysAllocate(byte, Size + HeaderSize);
-  allocator::bump *Output = (allocator::bump *)RawMemory;
 
+  if (!RawMemory)
+  {
+    return 0x0;
+  }
+
+  allocator::bump *Output = (allocator::bump *)RawMemory;
   Output->Begin = RawMemory + HeaderSize;
   Output->Offset = Output->Begin;
-  Output->End = Output->Begin ? Output->Begin + Size : 0x0;
+  Output->End = Output->Begin + Size;
 
   return Output;
 }
@@ -62,3 +67,18 @@ key allocator::MemoryUsed(allocator::bump *Allocator)
 {
   return Allocator->Offset - Allocator->Begin;
 }
+
+allocator::bump_marker allocator::GetMarker(allocator::bump *Allocator)
+{
+  return {
+      .Allocator = Allocator,
+      .Offset = Allocator->Offset,
+  };
+}
+
+void allocator::Rollback(const allocator::bump_marker Marker)
+{
+  Assert(Marker.Offset >= Marker.Allocator->Begin && Marker.Offset <= Marker.Allocator->Offset,
+         "Marker was taken after the current offset or from another allocator.");
+  Marker.Allocator->Offset = Marker.Offset;
+}
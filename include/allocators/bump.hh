@@ -30,9 +30,17 @@ struct bump
   byte *End;
 };
 
+struct bump_marker
+{
+  allocator::bump *Allocator;
+  byte *Offset;
+};
+
 void *_Allocate(allocator::bump *Allocator, const key Align, const key Size);
 allocator::bump *CreateBump(const key Size);
 void Reset(allocator::bump *Allocator);
 void Destroy(allocator::bump *Allocator);
 key MemoryUsed(allocator::bump *Allocator);
+allocator::bump_marker GetMarker(allocator::bump *Allocator);
+void Rollback(const allocator::bump_marker Marker);
 }; // namespace allocator
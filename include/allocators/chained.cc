@@ -0,0 +1,150 @@
+/*
+Chained allocator implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "chained.hh"
+
+static inline allocator::chained_block *InitializeBlock(byte *RawMemory, const key Size)
+{
+  key HeaderSize = sizeof(allocator::chained_block);
+  allocator::chained_block *Block = (allocator::chained_block *)RawMemory;
+
+  Block->Next = 0x0;
+  Block->Begin = RawMemory + HeaderSize;
+  Block->Offset = Block->Begin;
+  Block->End = Block->Begin + Size;
+
+  return Block;
+}
+
+allocator::chained *allocator::CreateChained(const key BlockSize)
+{
+  key HeaderSize = sizeof(allocator::chained) + sizeof(allocator::chained_block);
+  byte *RawMemory = SysAllocate(byte, BlockSize + HeaderSize);
+
+  if (!RawMemory)
+  {
+    return 0x0;
+  }
+
+  allocator::chained *Output = (allocator::chained *)RawMemory;
+  Output->BlockSize = BlockSize;
+  Output->First = InitializeBlock(RawMemory + sizeof(allocator::chained), BlockSize);
+  Output->Current = Output->First;
+
+  return Output;
+}
+
+void *allocator::_Allocate(allocator::chained *Allocator, const key Align, const key Size)
+{
+  if (Size == 0)
+  {
+    return 0x0;
+  }
+
+  allocator::chained_block *Block = Allocator->Current;
+
+  for (;;)
+  {
+    key_diff Padding = GetPadding(Block->Offset, Align);
+    key_diff Available = Block->End - Block->Offset - Padding;
+
+    if (Available > 0 && Size <= key(Available))
+    {
+      void *Output = Block->Offset + Padding;
+      Block->Offset += Size + Padding;
+      Allocator->Current = Block;
+      return Output;
+    }
+
+    if (!Block->Next)
+    {
+      break;
+    }
+
+    // blocks past Current are only left over from a previous Reset
+    Block = Block->Next;
+  }
+
+  // oversized requests get a dedicated block large enough to absorb the worst case padding
+  key BlockSize = Size + Align > Allocator->BlockSize ? Size + Align : Allocator->BlockSize;
+  byte *RawMemory = SysAllocate(byte, BlockSize + sizeof(allocator::chained_block));
+
+  if (!RawMemory)
+  {
+    return 0x0;
+  }
+
+  allocator::chained_block *NewBlock = InitializeBlock(RawMemory, BlockSize);
+  Block->Next = NewBlock;
+
+  key_diff Padding = GetPadding(NewBlock->Offset, Align);
+  void *Output = NewBlock->Offset + Padding;
+  NewBlock->Offset += Size + Padding;
+  Allocator->Current = NewBlock;
+
+  return Output;
+}
+
+void allocator::Reset(allocator::chained *Allocator)
+{
+  for (allocator::chained_block *Block = Allocator->First; Block; Block = Block->Next)
+  {
+    Block->Offset = Block->Begin;
+  }
+
+  Allocator->Current = Allocator->First;
+}
+
+void allocator::Destroy(allocator::chained *Allocator)
+{
+  // first block lives in the same allocation as the header
+  allocator::chained_block *Block = Allocator->First->Next;
+
+  while (Block)
+  {
+    allocator::chained_block *Next = Block->Next;
+    SysFree(Block);
+    Block = Next;
+  }
+
+  SysFree(Allocator);
+}
+
+key allocator::MemoryUsed(allocator::chained *Allocator)
+{
+  key Used = 0;
+
+  for (allocator::chained_block *Block = Allocator->First; Block; Block = Block->Next)
+  {
+    Used += Block->Offset - Block->Begin;
+  }
+
+  return Used;
+}
+
+key allocator::MemoryReserved(allocator::chained *Allocator)
+{
+  key Reserved = 0;
+
+  for (allocator::chained_block *Block = Allocator->First; Block; Block = Block->Next)
+  {
+    Reserved += Block->End - Block->Begin;
+  }
+
+  return Reserved;
+}
@@ -0,0 +1,49 @@
+/*
+Chained allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "../common.hh"
+
+namespace allocator
+{
+struct chained_block
+{
+  allocator::chained_block *Next;
+  byte *Begin;
+  byte *Offset;
+  byte *End;
+};
+
+// Bump allocator that links a new block when the current one is full instead of asserting.
+// Blocks are kept on Reset so a warmed up allocator stops calling SysAllocate.
+struct chained
+{
+  key BlockSize;
+  allocator::chained_block *First;
+  allocator::chained_block *Current;
+};
+
+void *_Allocate(allocator::chained *Allocator, const key Align, const key Size);
+allocator::chained *CreateChained(const key BlockSize);
+void Reset(allocator::chained *Allocator);
+void Destroy(allocator::chained *Allocator);
+key MemoryUsed(allocator::chained *Allocator);
+key MemoryReserved(allocator::chained *Allocator);
+}; // namespace allocator
@@ -0,0 +1,224 @@
+/*
+Compacting handle allocator implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "compact.hh"
+
+// libc
+#include <string.h>
+#include <time.h>
+
+// clock is only read every N steps that don't move memory
+#define __COMPACT__CLOCK_INTERVAL 64
+
+static inline tick GetNanoseconds()
+{
+  timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return tick(Time.tv_sec) * 1000000000 + tick(Time.tv_nsec);
+}
+
+static inline allocator::compact_block *GetBlock(const byte *Memory)
+{
+  return (allocator::compact_block *)(Memory - sizeof(allocator::compact_block));
+}
+
+static inline void LinkEntries(allocator::compact *Allocator)
+{
+  for (u32 Index = 0; Index < Allocator->EntryCount; Index++)
+  {
+    allocator::compact_entry *Entry = &Allocator->Entries[Index];
+    Entry->Memory = 0x0;
+    Entry->Generation = Entry->Generation ? Entry->Generation : 1;
+    Entry->NextFree = Index + 1 < Allocator->EntryCount ? Index + 1 : __COMPACT__FREE_ENTRY;
+  }
+
+  Allocator->FreeEntry = Allocator->EntryCount ? 0 : __COMPACT__FREE_ENTRY;
+}
+
+allocator::compact *allocator::CreateCompact(const key Size, const u32 HandleCount)
+{
+  key HeaderSize = sizeof(allocator::compact) + sizeof(allocator::compact_entry) * HandleCount;
+  HeaderSize = (HeaderSize + __COMPACT__ALIGN - 1) & ~key(__COMPACT__ALIGN - 1);
+  byte *RawMemory = SysAllocate(byte, Size + HeaderSize);
+
+  if (!RawMemory)
+  {
+    return 0x0;
+  }
+
+  allocator::compact *Output = (allocator::compact *)RawMemory;
+  Output->Begin = RawMemory + HeaderSize;
+  Output->Offset = Output->Begin;
+  Output->End = Output->Begin + Size;
+  Output->Cursor = Output->Begin;
+  Output->LiveSize = 0;
+
+  Output->Entries = (allocator::compact_entry *)(RawMemory + sizeof(allocator::compact));
+  Output->EntryCount = HandleCount;
+  LinkEntries(Output);
+
+  return Output;
+}
+
+allocator::compact_handle allocator::AllocateHandle(allocator::compact *Allocator,
+                                                    const key Align, const key Size)
+{
+  Assert(Align <= __COMPACT__ALIGN, "Compact allocator only aligns up to 16 bytes.");
+
+  key BlockSize = sizeof(allocator::compact_block) + Size;
+  BlockSize = (BlockSize + __COMPACT__ALIGN - 1) & ~key(__COMPACT__ALIGN - 1);
+
+  // out of handles or room at the end, the caller can Defrag and try again
+  if (Size == 0 || Allocator->FreeEntry == __COMPACT__FREE_ENTRY ||
+      key(Allocator->End - Allocator->Offset) < BlockSize)
+  {
+    return {.Index = 0, .Generation = 0};
+  }
+
+  u32 Index = Allocator->FreeEntry;
+  allocator::compact_entry *Entry = &Allocator->Entries[Index];
+  Allocator->FreeEntry = Entry->NextFree;
+
+  allocator::compact_block *Block = (allocator::compact_block *)Allocator->Offset;
+  Block->Entry = Index;
+  Block->Size = BlockSize;
+
+  Entry->Memory = Allocator->Offset + sizeof(allocator::compact_block);
+  Allocator->Offset += BlockSize;
+  Allocator->LiveSize += BlockSize;
+
+  return {.Index = Index, .Generation = Entry->Generation};
+}
+
+bool32 allocator::IsValid(allocator::compact *Allocator, const allocator::compact_handle Handle)
+{
+  return Handle.Generation && Handle.Index < Allocator->EntryCount &&
+         Allocator->Entries[Handle.Index].Generation == Handle.Generation;
+}
+
+void allocator::Free(allocator::compact *Allocator, const allocator::compact_handle Handle)
+{
+  Assert(allocator::IsValid(Allocator, Handle), "Handle was freed twice or is invalid.");
+
+  allocator::compact_entry *Entry = &Allocator->Entries[Handle.Index];
+  allocator::compact_block *Block = GetBlock(Entry->Memory);
+  Block->Entry = __COMPACT__FREE_ENTRY;
+  Allocator->LiveSize -= Block->Size;
+
+  Entry->Memory = 0x0;
+  Entry->Generation = Entry->Generation + 1 ? Entry->Generation + 1 : 1;
+  Entry->NextFree = Allocator->FreeEntry;
+  Allocator->FreeEntry = Handle.Index;
+}
+
+void *allocator::GetPointer(allocator::compact *Allocator, const allocator::compact_handle Handle)
+{
+  Assert(allocator::IsValid(Allocator, Handle), "Handle was freed or is invalid.");
+  return Allocator->Entries[Handle.Index].Memory;
+}
+
+bool32 allocator::Defrag(allocator::compact *Allocator, const tick BudgetNanoseconds)
+{
+  tick Start = GetNanoseconds();
+  key Steps = 0;
+
+  // Cursor persists between calls, every free block it reaches is merged with the next one or
+  // swapped with the live block after it, which walks the hole up to Offset where it's trimmed
+  while (Allocator->Offset - Allocator->Begin > key_diff(Allocator->LiveSize))
+  {
+    if (Allocator->Cursor >= Allocator->Offset)
+    {
+      Allocator->Cursor = Allocator->Begin;
+    }
+
+    allocator::compact_block *Block = (allocator::compact_block *)Allocator->Cursor;
+    byte *Next = Allocator->Cursor + Block->Size;
+    bool32 Moved = false;
+
+    if (Block->Entry != __COMPACT__FREE_ENTRY)
+    {
+      Allocator->Cursor = Next;
+    }
+    else if (Next == Allocator->Offset)
+    {
+      Allocator->Offset = Allocator->Cursor;
+      Allocator->Cursor = Allocator->Begin;
+    }
+    else if (((allocator::compact_block *)Next)->Entry == __COMPACT__FREE_ENTRY)
+    {
+      Block->Size += ((allocator::compact_block *)Next)->Size;
+    }
+    else
+    {
+      key Gap = Block->Size;
+      allocator::compact_block *Live = (allocator::compact_block *)Next;
+      key LiveSize = Live->Size;
+      allocator::compact_entry *Entry = &Allocator->Entries[Live->Entry];
+
+      memmove(Allocator->Cursor, Next, LiveSize);
+      Entry->Memory -= Gap;
+      Allocator->Cursor += LiveSize;
+
+      allocator::compact_block *Hole = (allocator::compact_block *)Allocator->Cursor;
+      Hole->Entry = __COMPACT__FREE_ENTRY;
+      Hole->Size = Gap;
+      Moved = true;
+    }
+
+    if ((Moved || ++Steps % __COMPACT__CLOCK_INTERVAL == 0) &&
+        GetNanoseconds() - Start >= BudgetNanoseconds)
+    {
+      break;
+    }
+  }
+
+  return Allocator->Offset - Allocator->Begin == key_diff(Allocator->LiveSize);
+}
+
+void allocator::Reset(allocator::compact *Allocator)
+{
+  for (u32 Index = 0; Index < Allocator->EntryCount; Index++)
+  {
+    // outstanding handles must not resolve into the recycled heap
+    if (Allocator->Entries[Index].Memory)
+    {
+      allocator::compact_entry *Entry = &Allocator->Entries[Index];
+      Entry->Generation = Entry->Generation + 1 ? Entry->Generation + 1 : 1;
+    }
+  }
+
+  LinkEntries(Allocator);
+  Allocator->Offset = Allocator->Begin;
+  Allocator->Cursor = Allocator->Begin;
+  Allocator->LiveSize = 0;
+}
+
+void allocator::Destroy(allocator::compact *Allocator)
+{
+  SysFree(Allocator);
+}
+
+key allocator::MemoryUsed(allocator::compact *Allocator)
+{
+  return Allocator->LiveSize;
+}
+
+key allocator::MemoryFragmented(allocator::compact *Allocator)
+{
+  return (Allocator->Offset - Allocator->Begin) - Allocator->LiveSize;
+}
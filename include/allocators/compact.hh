@@ -0,0 +1,82 @@
+/*
+Compacting handle allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "../common.hh"
+
+#define __COMPACT__ALIGN 16
+#define __COMPACT__FREE_ENTRY U32_MAX
+
+namespace allocator
+{
+// Generation 0 is never handed out so a zeroed handle is always invalid.
+struct compact_handle
+{
+  u32 Index;
+  u32 Generation;
+};
+
+struct compact_entry
+{
+  byte *Memory;
+  u32 Generation;
+  u32 NextFree;
+};
+
+// Precedes every block in the heap, free blocks have Entry set to __COMPACT__FREE_ENTRY.
+struct compact_block
+{
+  u32 Entry;
+  u32 Padding;
+  key Size;
+};
+
+// Bump allocated heap addressed through handles, Defrag slides live blocks down over freed ones
+// a few at a time so it can run under a time budget every frame. Pointers from GetPointer are
+// only valid until the next call to Defrag.
+struct compact
+{
+  byte *Begin;
+  byte *Offset;
+  byte *End;
+  byte *Cursor;
+  key LiveSize;
+
+  allocator::compact_entry *Entries;
+  u32 EntryCount;
+  u32 FreeEntry;
+};
+
+allocator::compact *CreateCompact(const key Size, const u32 HandleCount);
+allocator::compact_handle AllocateHandle(allocator::compact *Allocator, const key Align,
+                                         const key Size);
+void Free(allocator::compact *Allocator, const allocator::compact_handle Handle);
+void *GetPointer(allocator::compact *Allocator, const allocator::compact_handle Handle);
+bool32 IsValid(allocator::compact *Allocator, const allocator::compact_handle Handle);
+bool32 Defrag(allocator::compact *Allocator, const tick BudgetNanoseconds);
+void Reset(allocator::compact *Allocator);
+void Destroy(allocator::compact *Allocator);
+key MemoryUsed(allocator::compact *Allocator);
+key MemoryFragmented(allocator::compact *Allocator);
+}; // namespace allocator
+
+#define AllocateHandleN(_Block, _Type, _Length)                                                    \
+  AllocateHandle(_Block, alignof(_Type), sizeof(_Type) * _Length)
+#define GetPointerAs(_Block, _Handle, _Type) (_Type *)GetPointer(_Block, _Handle)
@@ -0,0 +1,149 @@
+/*
+Pool allocator implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pool.hh"
+
+static inline byte *FirstSlot(allocator::pool_page *Page)
+{
+  byte *Offset = (byte *)Page + sizeof(allocator::pool_page);
+  return Offset + GetPadding(Offset, __POOL__CACHE_LINE);
+}
+
+// pushes every slot of the page on the free list, last slot first so allocation walks forward
+static inline void LinkPageSlots(allocator::pool *Allocator, allocator::pool_page *Page)
+{
+  byte *Slots = FirstSlot(Page);
+
+  for (key Index = Allocator->SlotsPerPage; Index > 0; Index--)
+  {
+    byte *SlotMemory = Slots + (Index - 1) * Allocator->SlotSize;
+    allocator::pool_slot *Slot = (allocator::pool_slot *)SlotMemory;
+    Slot->Next = Allocator->FreeList;
+    Allocator->FreeList = Slot;
+  }
+}
+
+static inline bool32 GrowPool(allocator::pool *Allocator)
+{
+  // extra cache line covers the page header and the padding to the first slot
+  byte *RawMemory = SysAllocate(byte, Allocator->PageSize + __POOL__CACHE_LINE);
+
+  if (!RawMemory)
+  {
+    return false;
+  }
+
+  allocator::pool_page *Page = (allocator::pool_page *)RawMemory;
+  Page->Next = Allocator->Pages;
+  Allocator->Pages = Page;
+
+  LinkPageSlots(Allocator, Page);
+  return true;
+}
+
+allocator::pool *allocator::CreatePool(const key SlotSize, const key PageSize)
+{
+  allocator::pool *Output = SysAllocate(allocator::pool, 1);
+
+  if (!Output)
+  {
+    return 0x0;
+  }
+
+  key Size = SlotSize > sizeof(allocator::pool_slot) ? SlotSize : sizeof(allocator::pool_slot);
+  Output->SlotSize = (Size + __POOL__CACHE_LINE - 1) & ~key(__POOL__CACHE_LINE - 1);
+  Output->PageSize = PageSize > Output->SlotSize ? PageSize : Output->SlotSize;
+  Output->SlotsPerPage = Output->PageSize / Output->SlotSize;
+  Output->SlotCount = 0;
+  Output->FreeList = 0x0;
+  Output->Pages = 0x0;
+
+  return Output;
+}
+
+allocator::pool *allocator::CreatePool(const key SlotSize)
+{
+  return allocator::CreatePool(SlotSize, __POOL__DEFAULT_PAGE_SIZE);
+}
+
+void *allocator::_Allocate(allocator::pool *Allocator, const key Align, const key Size)
+{
+  if (Size == 0)
+  {
+    return 0x0;
+  }
+
+  Assert(Size <= Allocator->SlotSize && Align <= __POOL__CACHE_LINE,
+         "Allocation does not fit in a pool slot.");
+
+  if (!Allocator->FreeList && !GrowPool(Allocator))
+  {
+    return 0x0;
+  }
+
+  allocator::pool_slot *Slot = Allocator->FreeList;
+  Allocator->FreeList = Slot->Next;
+  Allocator->SlotCount++;
+
+  return Slot;
+}
+
+void allocator::Free(allocator::pool *Allocator, void *Memory)
+{
+  if (!Memory)
+  {
+    return;
+  }
+
+  Assert(Allocator->SlotCount > 0, "Pool slot was freed twice or belongs to another pool.");
+
+  allocator::pool_slot *Slot = (allocator::pool_slot *)Memory;
+  Slot->Next = Allocator->FreeList;
+  Allocator->FreeList = Slot;
+  Allocator->SlotCount--;
+}
+
+void allocator::Reset(allocator::pool *Allocator)
+{
+  Allocator->FreeList = 0x0;
+  Allocator->SlotCount = 0;
+
+  for (allocator::pool_page *Page = Allocator->Pages; Page; Page = Page->Next)
+  {
+    LinkPageSlots(Allocator, Page);
+  }
+}
+
+void allocator::Destroy(allocator::pool *Allocator)
+{
+  allocator::pool_page *Page = Allocator->Pages;
+
+  while (Page)
+  {
+    allocator::pool_page *Next = Page->Next;
+    SysFree(Page);
+    Page = Next;
+  }
+
+  SysFree(Allocator);
+}
+
+key allocator::MemoryUsed(allocator::pool *Allocator)
+{
+  return Allocator->SlotCount * Allocator->SlotSize;
+}
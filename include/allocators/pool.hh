@@ -0,0 +1,61 @@
+/*
+Pool allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "../common.hh"
+
+#define __POOL__CACHE_LINE 64
+#define __POOL__DEFAULT_PAGE_SIZE (64 * KILOBYTE)
+
+namespace allocator
+{
+struct pool_slot
+{
+  allocator::pool_slot *Next;
+};
+
+struct pool_page
+{
+  allocator::pool_page *Next;
+};
+
+// Fixed size slots on cache line boundaries, free slots are linked through their own memory.
+// A new page of PageSize bytes is allocated whenever the free list runs out.
+struct pool
+{
+  key SlotSize;
+  key SlotsPerPage;
+  key PageSize;
+  key SlotCount;
+
+  allocator::pool_slot *FreeList;
+  allocator::pool_page *Pages;
+};
+
+void *_Allocate(allocator::pool *Allocator, const key Align, const key Size);
+void Free(allocator::pool *Allocator, void *Memory);
+allocator::pool *CreatePool(const key SlotSize);
+allocator::pool *CreatePool(const key SlotSize, const key PageSize);
+void Reset(allocator::pool *Allocator);
+void Destroy(allocator::pool *Allocator);
+key MemoryUsed(allocator::pool *Allocator);
+}; // namespace allocator
+
+#define CreatePoolFor(_Type) allocator::CreatePool(sizeof(_Type))
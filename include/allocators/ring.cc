@@ -0,0 +1,174 @@
+/*
+Ring allocator implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ring.hh"
+
+// lengths are multiples of the header size so the lowest bit is free to mark wrap around skips
+#define __RING__SKIP_FLAG 1
+
+static inline key LoadCounter(const allocator::ring *Allocator, const key *Counter)
+{
+  if (HasFlag(Allocator->Flags, allocator::RING_FLAG_CONCURRENT))
+  {
+    return __atomic_load_n(Counter, __ATOMIC_ACQUIRE);
+  }
+
+  return *Counter;
+}
+
+static inline void StoreCounter(const allocator::ring *Allocator, key *Counter, const key Value)
+{
+  if (HasFlag(Allocator->Flags, allocator::RING_FLAG_CONCURRENT))
+  {
+    __atomic_store_n(Counter, Value, __ATOMIC_RELEASE);
+  }
+  else
+  {
+    *Counter = Value;
+  }
+}
+
+static inline key GetLength(const byte *Header, const key Align, const key Size)
+{
+  key Padding = GetPadding(Header + sizeof(allocator::ring_header), Align);
+  key Length = sizeof(allocator::ring_header) + Padding + Size;
+  return (Length + sizeof(allocator::ring_header) - 1) & ~(sizeof(allocator::ring_header) - 1);
+}
+
+allocator::ring *allocator::CreateRing(const key Size, const key Flags)
+{
+  // power of two so positions are a mask of the monotonic counters
+  key Capacity = sizeof(allocator::ring_header);
+
+  while (Capacity < Size)
+  {
+    Capacity *= 2;
+  }
+
+  key HeaderSize = sizeof(allocator::ring);
+  byte *RawMemory = SysAllocate(byte, Capacity + HeaderSize);
+
+  if (!RawMemory)
+  {
+    return 0x0;
+  }
+
+  allocator::ring *Output = (allocator::ring *)RawMemory;
+  Output->Begin = RawMemory + HeaderSize;
+  Output->Capacity = Capacity;
+  Output->Flags = Flags;
+  Output->Head = 0;
+  Output->Tail = 0;
+
+  return Output;
+}
+
+allocator::ring *allocator::CreateRing(const key Size)
+{
+  return allocator::CreateRing(Size, allocator::RING_FLAG_NONE);
+}
+
+void *allocator::_Allocate(allocator::ring *Allocator, const key Align, const key Size)
+{
+  if (Size == 0)
+  {
+    return 0x0;
+  }
+
+  // Head is only written by the producer, Tail is published by the consumer
+  key Head = Allocator->Head;
+  key Tail = LoadCounter(Allocator, &Allocator->Tail);
+  key Position = Head & (Allocator->Capacity - 1);
+
+  byte *Header = Allocator->Begin + Position;
+  key Length = GetLength(Header, Align, Size);
+  key Skip = 0;
+
+  if (Position + Length > Allocator->Capacity)
+  {
+    Skip = Allocator->Capacity - Position;
+    Header = Allocator->Begin;
+    Length = GetLength(Header, Align, Size);
+  }
+
+  // with at most half the ring, an allocation always fits once the ring drained, however much of
+  // the block the wrap skips
+  Assert(Length <= Allocator->Capacity / 2, "Allocation is larger than half the ring.");
+
+  if (Skip + Length > Allocator->Capacity - (Head - Tail))
+  {
+    return 0x0;
+  }
+
+  if (Skip)
+  {
+    allocator::ring_header *SkipHeader = (allocator::ring_header *)(Allocator->Begin + Position);
+    SkipHeader->Length = Skip | __RING__SKIP_FLAG;
+  }
+
+  ((allocator::ring_header *)Header)->Length = Length;
+  StoreCounter(Allocator, &Allocator->Head, Head + Skip + Length);
+
+  byte *Output = Header + sizeof(allocator::ring_header);
+  return Output + GetPadding(Output, Align);
+}
+
+void allocator::Free(allocator::ring *Allocator, void *Memory)
+{
+  if (!Memory)
+  {
+    return;
+  }
+
+  // Tail is only written by the consumer, Head is published by the producer
+  key Tail = Allocator->Tail;
+  key Head = LoadCounter(Allocator, &Allocator->Head);
+
+  Assert(Head != Tail, "Ring was freed more times than it was allocated.");
+
+  allocator::ring_header *Header =
+      (allocator::ring_header *)(Allocator->Begin + (Tail & (Allocator->Capacity - 1)));
+
+  if (Header->Length & __RING__SKIP_FLAG)
+  {
+    Tail += Header->Length & ~key(__RING__SKIP_FLAG);
+    Header = (allocator::ring_header *)Allocator->Begin;
+  }
+
+  Assert((byte *)Memory > (byte *)Header && (byte *)Memory < (byte *)Header + Header->Length,
+         "Ring allocations must be freed in allocation order.");
+
+  StoreCounter(Allocator, &Allocator->Tail, Tail + Header->Length);
+}
+
+void allocator::Reset(allocator::ring *Allocator)
+{
+  StoreCounter(Allocator, &Allocator->Tail, 0);
+  StoreCounter(Allocator, &Allocator->Head, 0);
+}
+
+void allocator::Destroy(allocator::ring *Allocator)
+{
+  SysFree(Allocator);
+}
+
+key allocator::MemoryUsed(allocator::ring *Allocator)
+{
+  key Tail = LoadCounter(Allocator, &Allocator->Tail);
+  return LoadCounter(Allocator, &Allocator->Head) - Tail;
+}
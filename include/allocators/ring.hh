@@ -0,0 +1,65 @@
+/*
+Ring allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "../common.hh"
+
+#define __RING__CACHE_LINE 64
+
+namespace allocator
+{
+enum ring_flag
+{
+  RING_FLAG_NONE = 0,
+  RING_FLAG_CONCURRENT = 0b1, // One producer thread allocates while one consumer thread frees
+};
+
+// Precedes every allocation, Length covers the header, padding and data up to the next header.
+struct ring_header
+{
+  key Length;
+};
+
+// FIFO allocator, memory is handed out contiguously and must be freed in allocation order.
+// An allocation that doesn't fit before the end of the block wraps around to the beginning.
+// _Allocate returns 0x0 while the ring is full so producers can wait on the consumer. Allocations,
+// header and padding included, must fit in half the capacity or _Allocate asserts.
+struct ring
+{
+  byte *Begin;
+  key Capacity;
+  key Flags;
+
+  // monotonic counters, their difference is the memory in use
+  byte HeadPadding[__RING__CACHE_LINE - sizeof(byte *) - sizeof(key) * 2];
+  key Head;
+  byte TailPadding[__RING__CACHE_LINE - sizeof(key)];
+  key Tail;
+  byte EndPadding[__RING__CACHE_LINE - sizeof(key)];
+};
+
+void *_Allocate(allocator::ring *Allocator, const key Align, const key Size);
+void Free(allocator::ring *Allocator, void *Memory);
+allocator::ring *CreateRing(const key Size);
+allocator::ring *CreateRing(const key Size, const key Flags);
+void Reset(allocator::ring *Allocator);
+void Destroy(allocator::ring *Allocator);
+key MemoryUsed(allocator::ring *Allocator);
+}; // namespace allocator
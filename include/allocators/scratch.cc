@@ -0,0 +1,64 @@
+/*
+Thread local scratch allocator implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "scratch.hh"
+
+struct scratch_pool
+{
+  allocator::virtual_bump *Arenas[__SCRATCH__COUNT];
+
+  ~scratch_pool()
+  {
+    for (key Index = 0; Index < __SCRATCH__COUNT; Index++)
+    {
+      if (Arenas[Index])
+      {
+        allocator::Destroy(Arenas[Index]);
+      }
+    }
+  }
+};
+
+static thread_local scratch_pool ScratchPool;
+
+allocator::virtual_bump *allocator::GetScratch(const allocator::virtual_bump *Conflict)
+{
+  for (key Index = 0; Index < __SCRATCH__COUNT; Index++)
+  {
+    allocator::virtual_bump **Arena = &ScratchPool.Arenas[Index];
+
+    if (!*Arena)
+    {
+      // created on first use so threads that never need scratch memory don't pay for it
+      *Arena = allocator::CreateVirtualBump(__SCRATCH__SIZE);
+      Assert(*Arena, "Could not reserve scratch arena.");
+    }
+
+    if (*Arena != Conflict)
+    {
+      return *Arena;
+    }
+  }
+
+  return 0x0;
+}
+
+allocator::virtual_bump *allocator::GetScratch()
+{
+  return allocator::GetScratch(0x0);
+}
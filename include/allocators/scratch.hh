@@ -0,0 +1,62 @@
+/*
+Thread local scratch allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "virtual_bump.hh"
+#include "../common.hh"
+
+// Address space reserved for each arena, pages are only committed as far as the arena was used.
+#ifndef __SCRATCH__SIZE
+#define __SCRATCH__SIZE (key(4) * GIGABYTE)
+#endif
+
+#define __SCRATCH__COUNT 2
+
+namespace allocator
+{
+// Every thread owns two scratch arenas. A function that allocates its result in one of them passes
+// it as Conflict, so its own temporaries come from the other one and never overwrite the result.
+allocator::virtual_bump *GetScratch(const allocator::virtual_bump *Conflict);
+allocator::virtual_bump *GetScratch();
+
+// Rolls the scratch arena back to where it was on construction when leaving the scope.
+//
+//   allocator::scratch Scratch(ResultArena);
+//   byte *Staging = AllocateN(Scratch.Allocator, byte, Length);
+struct scratch
+{
+  allocator::virtual_bump *Allocator;
+  allocator::virtual_bump_marker Marker;
+
+  scratch(const allocator::virtual_bump *Conflict = 0x0)
+  {
+    Allocator = allocator::GetScratch(Conflict);
+    Marker = allocator::GetMarker(Allocator);
+  }
+
+  ~scratch()
+  {
+    allocator::Rollback(Marker);
+  }
+
+  scratch(const scratch &) = delete;
+  scratch &operator=(const scratch &) = delete;
+};
+}; // namespace allocator
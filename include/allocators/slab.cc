@@ -0,0 +1,369 @@
+/*
+Slab allocator implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "slab.hh"
+
+// linux
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define __SLAB__CACHE_LINE 64
+#define __SLAB__HEADER_SIZE                                                                        \
+  ((sizeof(allocator::slab_span) + __SLAB__CACHE_LINE - 1) & ~key(__SLAB__CACHE_LINE - 1))
+
+// every class is a multiple of 16 and the ones that are multiples of 64 stay cache line aligned
+// since slots start right after the cache line aligned header
+static const key SlabClassSizes[__SLAB__CLASS_COUNT] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048,
+};
+
+static inline key GetClassIndex(const key Align, const key Size)
+{
+  if (Align <= __SLAB__CACHE_LINE)
+  {
+    for (key Index = 0; Index < __SLAB__CLASS_COUNT; Index++)
+    {
+      key SlotSize = SlabClassSizes[Index];
+
+      if (SlotSize >= Size && SlotSize % Align == 0)
+      {
+        return Index;
+      }
+    }
+  }
+
+  return __SLAB__LARGE_CLASS;
+}
+
+// maps Length bytes starting on a __SLAB__SPAN_SIZE boundary so headers can be found by masking
+static inline void *MapAligned(const key Length)
+{
+  key Padded = Length + __SLAB__SPAN_SIZE;
+  byte *Mapping =
+      (byte *)mmap(0x0, Padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if ((void *)Mapping == MAP_FAILED)
+  {
+    return 0x0;
+  }
+
+  byte *Aligned = (byte *)AlignUp(key(Mapping), __SLAB__SPAN_SIZE);
+  key Front = Aligned - Mapping;
+  key Back = Padded - Front - Length;
+
+  if (Front)
+  {
+    munmap(Mapping, Front);
+  }
+
+  if (Back)
+  {
+    munmap(Aligned + Length, Back);
+  }
+
+  return Aligned;
+}
+
+static inline allocator::slab_span *GetSpan(const void *Memory)
+{
+  return (allocator::slab_span *)(key(Memory) & ~key(__SLAB__SPAN_SIZE - 1));
+}
+
+static inline bool32 IsFull(const allocator::slab_span *Span)
+{
+  return !Span->FreeList && Span->Bump + Span->SlotSize > Span->End;
+}
+
+static inline void Unlink(allocator::slab_class *Class, allocator::slab_span *Span)
+{
+  if (Span->Previous)
+  {
+    Span->Previous->Next = Span->Next;
+  }
+  else
+  {
+    Class->Head = Span->Next;
+  }
+
+  if (Span->Next)
+  {
+    Span->Next->Previous = Span->Previous;
+  }
+  else
+  {
+    Class->Tail = Span->Previous;
+  }
+
+  Span->Next = 0x0;
+  Span->Previous = 0x0;
+}
+
+static inline void PushFront(allocator::slab_class *Class, allocator::slab_span *Span)
+{
+  Span->Previous = 0x0;
+  Span->Next = Class->Head;
+
+  if (Class->Head)
+  {
+    Class->Head->Previous = Span;
+  }
+  else
+  {
+    Class->Tail = Span;
+  }
+
+  Class->Head = Span;
+}
+
+static inline void PushBack(allocator::slab_class *Class, allocator::slab_span *Span)
+{
+  Span->Next = 0x0;
+  Span->Previous = Class->Tail;
+
+  if (Class->Tail)
+  {
+    Class->Tail->Next = Span;
+  }
+  else
+  {
+    Class->Head = Span;
+  }
+
+  Class->Tail = Span;
+}
+
+static inline void ResetSpan(allocator::slab_span *Span)
+{
+  Span->FreeList = 0x0;
+  Span->Bump = (byte *)Span + __SLAB__HEADER_SIZE;
+  Span->UsedCount = 0;
+}
+
+static inline allocator::slab_span *CreateSpan(const key ClassIndex)
+{
+  allocator::slab_span *Span = (allocator::slab_span *)MapAligned(__SLAB__SPAN_SIZE);
+
+  if (!Span)
+  {
+    return 0x0;
+  }
+
+  Span->Next = 0x0;
+  Span->Previous = 0x0;
+  Span->End = (byte *)Span + __SLAB__SPAN_SIZE;
+  Span->ClassIndex = ClassIndex;
+  Span->SlotSize = SlabClassSizes[ClassIndex];
+  Span->MappingLength = __SLAB__SPAN_SIZE;
+  ResetSpan(Span);
+
+  return Span;
+}
+
+static inline void *AllocateLarge(allocator::slab *Allocator, const key Align, const key Size)
+{
+  key PageSize = key(sysconf(_SC_PAGESIZE));
+  Assert(Align <= PageSize, "Slab allocator can't align past the page size.");
+
+  key DataOffset = AlignUp(__SLAB__HEADER_SIZE, Align);
+  key MappingLength = AlignUp(DataOffset + Size, PageSize);
+  allocator::slab_span *Span = (allocator::slab_span *)MapAligned(MappingLength);
+
+  if (!Span)
+  {
+    return 0x0;
+  }
+
+  Span->FreeList = 0x0;
+  Span->Bump = (byte *)Span + DataOffset;
+  Span->End = Span->Bump + Size;
+  Span->ClassIndex = __SLAB__LARGE_CLASS;
+  Span->SlotSize = Size;
+  Span->UsedCount = 1;
+  Span->MappingLength = MappingLength;
+
+  Span->Previous = 0x0;
+  Span->Next = Allocator->Large;
+
+  if (Allocator->Large)
+  {
+    Allocator->Large->Previous = Span;
+  }
+
+  Allocator->Large = Span;
+  Allocator->Used += Size;
+
+  return Span->Bump;
+}
+
+static inline void FreeLarge(allocator::slab *Allocator, allocator::slab_span *Span)
+{
+  if (Span->Previous)
+  {
+    Span->Previous->Next = Span->Next;
+  }
+  else
+  {
+    Allocator->Large = Span->Next;
+  }
+
+  if (Span->Next)
+  {
+    Span->Next->Previous = Span->Previous;
+  }
+
+  Allocator->Used -= Span->SlotSize;
+  munmap(Span, Span->MappingLength);
+}
+
+allocator::slab *allocator::CreateSlab()
+{
+  // zero initialized by SysAllocate, spans are only mapped on first use of their class
+  return SysAllocate(allocator::slab, 1);
+}
+
+void *allocator::_Allocate(allocator::slab *Allocator, const key Align, const key Size)
+{
+  if (Size == 0)
+  {
+    return 0x0;
+  }
+
+  key ClassIndex = GetClassIndex(Align, Size);
+
+  if (ClassIndex == __SLAB__LARGE_CLASS)
+  {
+    return AllocateLarge(Allocator, Align, Size);
+  }
+
+  allocator::slab_class *Class = &Allocator->Classes[ClassIndex];
+  allocator::slab_span *Span = Class->Head;
+
+  if (!Span || IsFull(Span))
+  {
+    Span = CreateSpan(ClassIndex);
+
+    if (!Span)
+    {
+      return 0x0;
+    }
+
+    PushFront(Class, Span);
+  }
+
+  void *Output;
+
+  if (Span->FreeList)
+  {
+    Output = Span->FreeList;
+    Span->FreeList = Span->FreeList->Next;
+  }
+  else
+  {
+    Output = Span->Bump;
+    Span->Bump += Span->SlotSize;
+  }
+
+  Span->UsedCount++;
+  Allocator->Used += Span->SlotSize;
+
+  // full spans live at the back so Head always has room when any span does
+  if (IsFull(Span))
+  {
+    Unlink(Class, Span);
+    PushBack(Class, Span);
+  }
+
+  return Output;
+}
+
+void allocator::Free(allocator::slab *Allocator, void *Memory)
+{
+  if (!Memory)
+  {
+    return;
+  }
+
+  allocator::slab_span *Span = GetSpan(Memory);
+
+  if (Span->ClassIndex == __SLAB__LARGE_CLASS)
+  {
+    FreeLarge(Allocator, Span);
+    return;
+  }
+
+  Assert(Span->UsedCount > 0, "Slab slot was freed twice or belongs to another allocator.");
+
+  bool32 WasFull = IsFull(Span);
+  allocator::slab_slot *Slot = (allocator::slab_slot *)Memory;
+  Slot->Next = Span->FreeList;
+  Span->FreeList = Slot;
+  Span->UsedCount--;
+  Allocator->Used -= Span->SlotSize;
+
+  if (WasFull)
+  {
+    allocator::slab_class *Class = &Allocator->Classes[Span->ClassIndex];
+    Unlink(Class, Span);
+    PushFront(Class, Span);
+  }
+}
+
+void allocator::Reset(allocator::slab *Allocator)
+{
+  for (key Index = 0; Index < __SLAB__CLASS_COUNT; Index++)
+  {
+    for (allocator::slab_span *Span = Allocator->Classes[Index].Head; Span; Span = Span->Next)
+    {
+      ResetSpan(Span);
+    }
+  }
+
+  while (Allocator->Large)
+  {
+    FreeLarge(Allocator, Allocator->Large);
+  }
+
+  Allocator->Used = 0;
+}
+
+void allocator::Destroy(allocator::slab *Allocator)
+{
+  for (key Index = 0; Index < __SLAB__CLASS_COUNT; Index++)
+  {
+    allocator::slab_span *Span = Allocator->Classes[Index].Head;
+
+    while (Span)
+    {
+      allocator::slab_span *Next = Span->Next;
+      munmap(Span, Span->MappingLength);
+      Span = Next;
+    }
+  }
+
+  while (Allocator->Large)
+  {
+    FreeLarge(Allocator, Allocator->Large);
+  }
+
+  SysFree(Allocator);
+}
+
+key allocator::MemoryUsed(allocator::slab *Allocator)
+{
+  return Allocator->Used;
+}
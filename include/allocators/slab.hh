@@ -0,0 +1,71 @@
+/*
+Slab allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "../common.hh"
+
+#define __SLAB__SPAN_SIZE (64 * KILOBYTE)
+#define __SLAB__CLASS_COUNT 14
+#define __SLAB__LARGE_CLASS __SLAB__CLASS_COUNT
+
+namespace allocator
+{
+struct slab_slot
+{
+  allocator::slab_slot *Next;
+};
+
+// Header at the start of every __SLAB__SPAN_SIZE aligned mapping, Free finds it by masking the
+// pointer so small allocations don't need a header of their own.
+struct slab_span
+{
+  allocator::slab_span *Next;
+  allocator::slab_span *Previous;
+  allocator::slab_slot *FreeList;
+  byte *Bump;
+  byte *End;
+
+  key ClassIndex;
+  key SlotSize;
+  key UsedCount;
+  key MappingLength;
+};
+
+// Spans of a size class keep the ones with free slots in front of the full ones.
+struct slab_class
+{
+  allocator::slab_span *Head;
+  allocator::slab_span *Tail;
+};
+
+struct slab
+{
+  allocator::slab_class Classes[__SLAB__CLASS_COUNT];
+  allocator::slab_span *Large;
+  key Used;
+};
+
+void *_Allocate(allocator::slab *Allocator, const key Align, const key Size);
+void Free(allocator::slab *Allocator, void *Memory);
+allocator::slab *CreateSlab();
+void Reset(allocator::slab *Allocator);
+void Destroy(allocator::slab *Allocator);
+key MemoryUsed(allocator::slab *Allocator);
+}; // namespace allocator
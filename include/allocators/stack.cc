@@ -0,0 +1,142 @@
+/*
+Double ended stack allocator implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stack.hh"
+
+allocator::stack *allocator::CreateStack(const key Size)
+{
+  key HeaderSize = sizeof(allocator::stack);
+  byte *RawMemory = SysAllocate(byte, Size + HeaderSize);
+
+  if (!RawMemory)
+  {
+    return 0x0;
+  }
+
+  allocator::stack *Output = (allocator::stack *)RawMemory;
+  Output->Begin = RawMemory + HeaderSize;
+  Output->End = Output->Begin + Size;
+
+  Output->Front.Stack = Output;
+  Output->Front.Offset = Output->Begin;
+  Output->Front.Direction = allocator::STACK_DIRECTION_FRONT;
+
+  Output->Back.Stack = Output;
+  Output->Back.Offset = Output->End;
+  Output->Back.Direction = allocator::STACK_DIRECTION_BACK;
+
+  return Output;
+}
+
+void *allocator::_Allocate(allocator::stack_side *Allocator, const key Align, const key Size)
+{
+  if (Size == 0)
+  {
+    return 0x0;
+  }
+
+  allocator::stack *Stack = Allocator->Stack;
+  key_diff Available = Stack->Back.Offset - Stack->Front.Offset;
+
+  if (Allocator->Direction == allocator::STACK_DIRECTION_FRONT)
+  {
+    key_diff Padding = GetPadding(Allocator->Offset, Align);
+
+    Assert(Available - Padding > 0 && Size <= key(Available - Padding),
+           "Stack allocator ends overlapped.");
+
+    void *Output = Allocator->Offset + Padding;
+    Allocator->Offset += Size + Padding;
+    return Output;
+  }
+
+  // back end grows down, so the padding goes above the allocation
+  key_diff Padding = key(Allocator->Offset - Size) & (Align - 1);
+
+  Assert(Available - Padding > 0 && Size <= key(Available - Padding),
+         "Stack allocator ends overlapped.");
+
+  Allocator->Offset -= Size + Padding;
+  return Allocator->Offset;
+}
+
+void allocator::Reset(allocator::stack_side *Allocator)
+{
+  allocator::stack *Stack = Allocator->Stack;
+  Allocator->Offset =
+      Allocator->Direction == allocator::STACK_DIRECTION_FRONT ? Stack->Begin : Stack->End;
+}
+
+void allocator::Reset(allocator::stack *Allocator)
+{
+  allocator::Reset(&Allocator->Front);
+  allocator::Reset(&Allocator->Back);
+}
+
+void allocator::Destroy(allocator::stack *Allocator)
+{
+  SysFree(Allocator);
+}
+
+key allocator::MemoryUsed(allocator::stack_side *Allocator)
+{
+  allocator::stack *Stack = Allocator->Stack;
+
+  if (Allocator->Direction == allocator::STACK_DIRECTION_FRONT)
+  {
+    return Allocator->Offset - Stack->Begin;
+  }
+
+  return Stack->End - Allocator->Offset;
+}
+
+key allocator::MemoryUsed(allocator::stack *Allocator)
+{
+  return allocator::MemoryUsed(&Allocator->Front) + allocator::MemoryUsed(&Allocator->Back);
+}
+
+key allocator::MemoryAvailable(allocator::stack *Allocator)
+{
+  return Allocator->Back.Offset - Allocator->Front.Offset;
+}
+
+allocator::stack_marker allocator::GetMarker(allocator::stack_side *Allocator)
+{
+  return {
+      .Side = Allocator,
+      .Offset = Allocator->Offset,
+  };
+}
+
+void allocator::Rollback(const allocator::stack_marker Marker)
+{
+  allocator::stack_side *Side = Marker.Side;
+
+  if (Side->Direction == allocator::STACK_DIRECTION_FRONT)
+  {
+    Assert(Marker.Offset >= Side->Stack->Begin && Marker.Offset <= Side->Offset,
+           "Marker was taken after the current offset or from another allocator.");
+  }
+  else
+  {
+    Assert(Marker.Offset <= Side->Stack->End && Marker.Offset >= Side->Offset,
+           "Marker was taken after the current offset or from another allocator.");
+  }
+
+  Side->Offset = Marker.Offset;
+}
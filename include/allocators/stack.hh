@@ -0,0 +1,69 @@
+/*
+Double ended stack allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "../common.hh"
+
+namespace allocator
+{
+struct stack;
+
+enum stack_direction
+{
+  STACK_DIRECTION_FRONT = 0, // Grows up from Begin
+  STACK_DIRECTION_BACK = 1,  // Grows down from End
+};
+
+// One end of a stack, passed to the Allocate macros like any other allocator.
+struct stack_side
+{
+  allocator::stack *Stack;
+  byte *Offset;
+  key Direction;
+};
+
+// Two bump allocators sharing one block from opposite ends, e.g. level data in front and frame
+// temporaries in the back. Either end asserts once it would cross the other.
+struct stack
+{
+  byte *Begin;
+  byte *End;
+
+  allocator::stack_side Front;
+  allocator::stack_side Back;
+};
+
+struct stack_marker
+{
+  allocator::stack_side *Side;
+  byte *Offset;
+};
+
+void *_Allocate(allocator::stack_side *Allocator, const key Align, const key Size);
+allocator::stack *CreateStack(const key Size);
+void Reset(allocator::stack_side *Allocator);
+void Reset(allocator::stack *Allocator);
+void Destroy(allocator::stack *Allocator);
+key MemoryUsed(allocator::stack_side *Allocator);
+key MemoryUsed(allocator::stack *Allocator);
+key MemoryAvailable(allocator::stack *Allocator);
+allocator::stack_marker GetMarker(allocator::stack_side *Allocator);
+void Rollback(const allocator::stack_marker Marker);
+}; // namespace allocator
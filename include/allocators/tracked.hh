@@ -0,0 +1,187 @@
+/*
+Tracking allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "../common.hh"
+
+#include <stdio.h>
+
+// Pass -D__TRACKED__ENABLED=1 to the whole build to record statistics, otherwise tracked<A> only
+// forwards calls. Never define it before an include: the templates below would get a different
+// body in different translation units and the linker would silently keep one of them.
+#ifndef __TRACKED__ENABLED
+#define __TRACKED__ENABLED 0
+#endif
+
+#define __TRACKED__HISTOGRAM_BUCKETS 32
+
+namespace allocator
+{
+// Bucket N counts allocations of (2^(N-1), 2^N] bytes, the last bucket takes everything larger.
+struct tracking_stats
+{
+  const char *Tag;
+  allocator::tracking_stats *Next;
+
+  key AllocationCount;
+  key FreeCount;
+  key BytesRequested;
+  key BytesWasted; // alignment padding and size class rounding as seen through MemoryUsed
+  key HighWater;
+  key Histogram[__TRACKED__HISTOGRAM_BUCKETS];
+};
+
+// Wraps any allocator from this folder, one instance per subsystem tag.
+template <typename A> struct tracked
+{
+  A *Allocator;
+  allocator::tracking_stats Stats;
+};
+
+inline allocator::tracking_stats **TrackingRegistry()
+{
+  static allocator::tracking_stats *Head = 0x0;
+  return &Head;
+}
+
+inline key HistogramBucket(const key Size)
+{
+  if (Size <= 1)
+  {
+    return 0;
+  }
+
+  key Bucket = key(64 - __builtin_clzll(u64(Size - 1)));
+  return Bucket < __TRACKED__HISTOGRAM_BUCKETS ? Bucket : __TRACKED__HISTOGRAM_BUCKETS - 1;
+}
+
+template <typename A> allocator::tracked<A> *CreateTracked(A *Allocator, const char *Tag)
+{
+  allocator::tracked<A> *Output = SysAllocate(allocator::tracked<A>, 1);
+  Output->Allocator = Allocator;
+  Output->Stats.Tag = Tag;
+
+#if __TRACKED__ENABLED
+  allocator::tracking_stats **Head = allocator::TrackingRegistry();
+  Output->Stats.Next = *Head;
+  *Head = &Output->Stats;
+#endif
+
+  return Output;
+}
+
+template <typename A>
+inline void *_Allocate(allocator::tracked<A> *Allocator, const key Align, const key Size)
+{
+#if __TRACKED__ENABLED
+  // unqualified so the wrapped overloads are found by ADL wherever their header was included
+  key Before = MemoryUsed(Allocator->Allocator);
+  void *Output = _Allocate(Allocator->Allocator, Align, Size);
+  key After = MemoryUsed(Allocator->Allocator);
+
+  allocator::tracking_stats *Stats = &Allocator->Stats;
+  Stats->AllocationCount++;
+  Stats->BytesRequested += Size;
+  Stats->BytesWasted += After > Before + Size ? After - Before - Size : 0;
+  Stats->HighWater = After > Stats->HighWater ? After : Stats->HighWater;
+  Stats->Histogram[allocator::HistogramBucket(Size)]++;
+
+  return Output;
+#else
+  return _Allocate(Allocator->Allocator, Align, Size);
+#endif
+}
+
+// only resolves for wrapped allocators that support Free
+template <typename A>
+inline auto Free(allocator::tracked<A> *Allocator, void *Memory)
+    -> decltype(Free(Allocator->Allocator, Memory))
+{
+#if __TRACKED__ENABLED
+  Allocator->Stats.FreeCount += Memory ? 1 : 0;
+#endif
+  Free(Allocator->Allocator, Memory);
+}
+
+template <typename A> inline void Reset(allocator::tracked<A> *Allocator)
+{
+  Reset(Allocator->Allocator);
+}
+
+template <typename A> inline key MemoryUsed(allocator::tracked<A> *Allocator)
+{
+  return MemoryUsed(Allocator->Allocator);
+}
+
+// Destroys the wrapper only, the wrapped allocator still belongs to the caller.
+template <typename A> void Destroy(allocator::tracked<A> *Allocator)
+{
+#if __TRACKED__ENABLED
+  allocator::tracking_stats **Link = allocator::TrackingRegistry();
+
+  while (*Link && *Link != &Allocator->Stats)
+  {
+    Link = &(*Link)->Next;
+  }
+
+  if (*Link)
+  {
+    *Link = Allocator->Stats.Next;
+  }
+#endif
+
+  SysFree(Allocator);
+}
+
+inline void Report(const allocator::tracking_stats *Stats, FILE *Output)
+{
+  fprintf(Output, "[%s] allocations: %lu, frees: %lu\n", Stats->Tag, Stats->AllocationCount,
+          Stats->FreeCount);
+  fprintf(Output, "  requested: %lu, wasted: %lu, high water: %lu\n", Stats->BytesRequested,
+          Stats->BytesWasted, Stats->HighWater);
+
+  for (key Bucket = 0; Bucket < __TRACKED__HISTOGRAM_BUCKETS; Bucket++)
+  {
+    if (Stats->Histogram[Bucket])
+    {
+      fprintf(Output, "  <= %12lu bytes: %lu\n", key(1) << Bucket, Stats->Histogram[Bucket]);
+    }
+  }
+}
+
+template <typename A> void Report(const allocator::tracked<A> *Allocator, FILE *Output)
+{
+  allocator::Report(&Allocator->Stats, Output);
+}
+
+// Reports every live tracked allocator, newest first.
+inline void ReportAll(FILE *Output)
+{
+#if __TRACKED__ENABLED
+  for (allocator::tracking_stats *Stats = *allocator::TrackingRegistry(); Stats;
+       Stats = Stats->Next)
+  {
+    allocator::Report(Stats, Output);
+  }
+#else
+  fprintf(Output, "Allocator tracking is disabled, build with -D__TRACKED__ENABLED=1.\n");
+#endif
+}
+}; // namespace allocator
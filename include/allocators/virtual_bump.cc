@@ -0,0 +1,155 @@
+/*
+Virtual memory bump allocator implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "virtual_bump.hh"
+
+// linux
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define __VIRTUAL_BUMP__COMMIT_SIZE (64 * KILOBYTE)
+#define __VIRTUAL_BUMP__HUGE_PAGE_SIZE (2 * MEGABYTE)
+
+allocator::virtual_bump *allocator::CreateVirtualBump(const key ReserveSize, const key Flags)
+{
+  key PageSize = key(sysconf(_SC_PAGESIZE));
+  key CommitSize = HasFlag(Flags, allocator::VIRTUAL_BUMP_FLAG_HUGE_PAGES)
+                       ? __VIRTUAL_BUMP__HUGE_PAGE_SIZE
+                       : __VIRTUAL_BUMP__COMMIT_SIZE;
+  CommitSize = CommitSize > PageSize ? CommitSize : PageSize;
+
+  // over-reserve by one commit step so Begin can be aligned for huge pages
+  key Size = AlignUp(ReserveSize, CommitSize);
+  key MappingLength = Size + CommitSize;
+  void *Mapping =
+      mmap(0x0, MappingLength, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (Mapping == MAP_FAILED)
+  {
+    return 0x0;
+  }
+
+  allocator::virtual_bump *Output = SysAllocate(allocator::virtual_bump, 1);
+
+  if (!Output)
+  {
+    munmap(Mapping, MappingLength);
+    return 0x0;
+  }
+
+  Output->Begin = (byte *)AlignUp(key(Mapping), CommitSize);
+  Output->Offset = Output->Begin;
+  Output->Committed = Output->Begin;
+  Output->End = Output->Begin + Size;
+  Output->CommitSize = CommitSize;
+  Output->Flags = Flags;
+  Output->Mapping = Mapping;
+  Output->MappingLength = MappingLength;
+
+  if (HasFlag(Flags, allocator::VIRTUAL_BUMP_FLAG_HUGE_PAGES))
+  {
+    // advisory only, falls back to regular pages when THP is disabled
+    madvise(Output->Begin, Size, MADV_HUGEPAGE);
+  }
+
+  return Output;
+}
+
+allocator::virtual_bump *allocator::CreateVirtualBump(const key ReserveSize)
+{
+  return allocator::CreateVirtualBump(ReserveSize, allocator::VIRTUAL_BUMP_FLAG_NONE);
+}
+
+void *allocator::_Allocate(allocator::virtual_bump *Allocator, const key Align, const key Size)
+{
+  if (Size == 0)
+  {
+    return 0x0;
+  }
+
+  key_diff Padding = GetPadding(Allocator->Offset, Align);
+  key_diff Available = Allocator->End - Allocator->Offset - Padding;
+
+  Assert(Available > 0 && Size <= key(Available), "Allocator overflow.");
+
+  byte *NewOffset = Allocator->Offset + Padding + Size;
+
+  if (NewOffset > Allocator->Committed)
+  {
+    byte *Committed =
+        Allocator->Begin + AlignUp(NewOffset - Allocator->Begin, Allocator->CommitSize);
+
+    if (mprotect(Allocator->Committed, Committed - Allocator->Committed,
+                 PROT_READ | PROT_WRITE))
+    {
+      return 0x0;
+    }
+
+    Allocator->Committed = Committed;
+  }
+
+  void *Output = Allocator->Offset + Padding;
+  Allocator->Offset = NewOffset;
+  return Output;
+}
+
+void allocator::Reset(allocator::virtual_bump *Allocator)
+{
+  Allocator->Offset = Allocator->Begin;
+
+  if (HasFlag(Allocator->Flags, allocator::VIRTUAL_BUMP_FLAG_DECOMMIT_ON_RESET) &&
+      Allocator->Committed > Allocator->Begin)
+  {
+    key Length = Allocator->Committed - Allocator->Begin;
+    madvise(Allocator->Begin, Length, MADV_DONTNEED);
+    mprotect(Allocator->Begin, Length, PROT_NONE);
+    Allocator->Committed = Allocator->Begin;
+  }
+}
+
+void allocator::Destroy(allocator::virtual_bump *Allocator)
+{
+  munmap(Allocator->Mapping, Allocator->MappingLength);
+  SysFree(Allocator);
+}
+
+key allocator::MemoryUsed(allocator::virtual_bump *Allocator)
+{
+  return Allocator->Offset - Allocator->Begin;
+}
+
+key allocator::MemoryCommitted(allocator::virtual_bump *Allocator)
+{
+  return Allocator->Committed - Allocator->Begin;
+}
+
+allocator::virtual_bump_marker allocator::GetMarker(allocator::virtual_bump *Allocator)
+{
+  return {
+      .Allocator = Allocator,
+      .Offset = Allocator->Offset,
+  };
+}
+
+// Pages past the marker stay committed for the next allocations to reuse.
+void allocator::Rollback(const allocator::virtual_bump_marker Marker)
+{
+  Assert(Marker.Offset >= Marker.Allocator->Begin && Marker.Offset <= Marker.Allocator->Offset,
+         "Marker was taken after the current offset or from another allocator.");
+  Marker.Allocator->Offset = Marker.Offset;
+}
@@ -0,0 +1,63 @@
+/*
+Virtual memory bump allocator header
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocator.hh"
+#include "../common.hh"
+
+namespace allocator
+{
+enum virtual_bump_flag
+{
+  VIRTUAL_BUMP_FLAG_NONE = 0,
+  VIRTUAL_BUMP_FLAG_HUGE_PAGES = 0b1,        // Ask for transparent huge pages, commits in 2MB steps
+  VIRTUAL_BUMP_FLAG_DECOMMIT_ON_RESET = 0b10, // Return committed pages to the OS on Reset
+};
+
+// Bump allocator over a reserved address range, pages are only committed once Offset reaches them.
+struct virtual_bump
+{
+  byte *Begin;
+  byte *Offset;
+  byte *Committed;
+  byte *End;
+
+  key CommitSize;
+  key Flags;
+
+  void *Mapping;
+  key MappingLength;
+};
+
+struct virtual_bump_marker
+{
+  allocator::virtual_bump *Allocator;
+  byte *Offset;
+};
+
+void *_Allocate(allocator::virtual_bump *Allocator, const key Align, const key Size);
+allocator::virtual_bump *CreateVirtualBump(const key ReserveSize);
+allocator::virtual_bump *CreateVirtualBump(const key ReserveSize, const key Flags);
+void Reset(allocator::virtual_bump *Allocator);
+void Destroy(allocator::virtual_bump *Allocator);
+key MemoryUsed(allocator::virtual_bump *Allocator);
+key MemoryCommitted(allocator::virtual_bump *Allocator);
+allocator::virtual_bump_marker GetMarker(allocator::virtual_bump *Allocator);
+void Rollback(const allocator::virtual_bump_marker Marker);
+}; // namespace allocator
@@ -46,12 +46,9 @@ inline vec2 ToCoordinates(const atlas::pack *Atlas, const vec2 Position)
   };
 }
 
-inline atlas::pack *CreateAtlas(const key TextureCount, const texture **Textures)
+// Smallest power of two square that fits every texture with some room to spare.
+inline key GetAtlasSize(const key TextureCount, const texture **Textures)
 {
-  atlas::pack *Result = SysAllocate(atlas::pack, 1);
-  Result->Size = TextureCount;
-  Result->Coordinates = SysAllocate(atlas::coordinates, TextureCount);
-
   key TotalSize = 0, Widest = 0, Tallest = 0;
   for (key TextureIndex = 0; TextureIndex < TextureCount; TextureIndex++)
   {
@@ -68,15 +65,19 @@ inline atlas::pack *CreateAtlas(const key TextureCount, const texture **Textures
     PowerOfTwo *= 2;
   }
 
-  Result->Texture = CreateEmptyTexture(PowerOfTwo, PowerOfTwo);
+  return PowerOfTwo;
+}
 
+// Copies the textures row by row into Atlas->Texture and fills in their coordinates.
+inline void PackTextures(atlas::pack *Atlas, const texture **Textures)
+{
   key IndexX = 0, IndexY = 0, RowTallest = 0;
 
-  for (key TextureIndex = 0; TextureIndex < TextureCount; TextureIndex++)
+  for (key TextureIndex = 0; TextureIndex < Atlas->Size; TextureIndex++)
   {
     const texture *Texture = Textures[TextureIndex];
 
-    if (IndexX + Texture->Width > Result->Texture->Width)
+    if (IndexX + Texture->Width > Atlas->Texture->Width)
     {
       IndexX = 0;
       IndexY += RowTallest;
@@ -87,18 +88,56 @@ inline atlas::pack *CreateAtlas(const key TextureCount, const texture **Textures
     {
       for (key X = 0; X < Texture->Width; X++)
       {
-        WritePixelAt(Result->Texture, X + IndexX, Y + IndexY, GetPixel(Texture, X, Y));
+        WritePixelAt(Atlas->Texture, X + IndexX, Y + IndexY, GetPixel(Texture, X, Y));
       }
     }
 
-    Result->Coordinates[TextureIndex].Start =
-        atlas::ToCoordinates(Result, vec2{.X = f32(IndexX), .Y = f32(IndexY)});
-    Result->Coordinates[TextureIndex].End = atlas::ToCoordinates(
-        Result, vec2{.X = f32(IndexX + Texture->Width), .Y = f32(IndexY + Texture->Height)});
+    Atlas->Coordinates[TextureIndex].Start =
+        atlas::ToCoordinates(Atlas, vec2{.X = f32(IndexX), .Y = f32(IndexY)});
+    Atlas->Coordinates[TextureIndex].End = atlas::ToCoordinates(
+        Atlas, vec2{.X = f32(IndexX + Texture->Width), .Y = f32(IndexY + Texture->Height)});
 
     RowTallest = Texture->Height > RowTallest ? Texture->Height : RowTallest;
     IndexX += Texture->Width;
   }
+}
+
+inline atlas::pack *CreateAtlas(const key TextureCount, const texture **Textures)
+{
+  atlas::pack *Result = SysAllocate(atlas::pack, 1);
+  Result->Size = TextureCount;
+  Result->Coordinates = SysAllocate(atlas::coordinates, TextureCount);
+
+  key Size = atlas::GetAtlasSize(TextureCount, Textures);
+  Result->Texture = CreateEmptyTexture(Size, Size);
+
+  atlas::PackTextures(Result, Textures);
+
+  return Result;
+}
+
+template <typename A>
+inline atlas::pack *CreateAtlas(A *Allocator, const key TextureCount, const texture **Textures)
+{
+  atlas::pack *Result = Allocate(Allocator, atlas::pack);
+
+  if (!Result)
+  {
+    return 0x0;
+  }
+
+  Result->Size = TextureCount;
+  Result->Coordinates = AllocateN(Allocator, atlas::coordinates, TextureCount);
+
+  key Size = atlas::GetAtlasSize(TextureCount, Textures);
+  Result->Texture = CreateEmptyTexture(Allocator, Size, Size);
+
+  if (!Result->Coordinates || !Result->Texture)
+  {
+    return 0x0;
+  }
+
+  atlas::PackTextures(Result, Textures);
 
   return Result;
 }
@@ -0,0 +1,749 @@
+/*
+File buffer implementation
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "buffer.hh"
+
+// libc
+#include <errno.h>
+#include <pthread.h>
+
+// linux
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#define __BUFFER__RING_ENTRIES 64
+#define __BUFFER__MAX_WORKERS 8
+// io_uring reads take a 32 bit length, larger files are read in several pieces
+#define __BUFFER__MAX_READ GIGABYTE
+// O_DIRECT wants addresses, lengths and offsets aligned to the logical block size
+#define __BUFFER__DIRECT_ALIGN 4096
+#define __BUFFER__MAX_VECTORS 1024
+// staging for whole file writes, only small pieces are copied, the rest goes straight to writev
+#define __BUFFER__WRITE_STAGING (64 * 1024)
+
+struct load_ring
+{
+  i32 File;
+  u32 Entries;
+
+  u32 *SubmitHead;
+  u32 *SubmitTail;
+  u32 *SubmitMask;
+  u32 *SubmitArray;
+  io_uring_sqe *Submissions;
+
+  u32 *CompleteHead;
+  u32 *CompleteTail;
+  u32 *CompleteMask;
+  io_uring_cqe *Completions;
+
+  void *SubmitRing;
+  key SubmitRingSize;
+  void *CompleteRing;
+  key CompleteRingSize;
+  key SubmissionsSize;
+};
+
+struct load_batch
+{
+  key Count;
+  const char **Paths;
+  buffer *Buffers;
+  buffer_access Access;
+
+  key Next;
+  key *Completed;
+  key CompletedCount;
+  pthread_mutex_t Mutex;
+  pthread_cond_t Condition;
+};
+
+// opens the file and allocates its buffer, returns -1 with a zero buffer when there is nothing
+// to read
+static inline i32 OpenLoad(const char *Path, const buffer_access Access, buffer *Buffer)
+{
+  *Buffer = ZeroLengthBuffer();
+  i32 File = open(Path, O_RDONLY);
+
+  if (File < 0)
+  {
+    return -1;
+  }
+
+  struct stat Status;
+
+  if (fstat(File, &Status) != 0 || !S_ISREG(Status.st_mode) || Status.st_size <= 0)
+  {
+    close(File);
+    return -1;
+  }
+
+  Buffer->Data = SysAllocate(byte, Status.st_size);
+
+  if (!Buffer->Data)
+  {
+    close(File);
+    return -1;
+  }
+
+  Buffer->Length = Status.st_size;
+  AdviseFileAccess(File, Access);
+
+  return File;
+}
+
+// blocking read of everything past Offset, a file that shrank is cut to what could be read
+static inline void ReadRemaining(const i32 File, buffer *Buffer, key Offset)
+{
+  while (Offset < Buffer->Length)
+  {
+    ssize_t Count = pread(File, (byte *)Buffer->Data + Offset, Buffer->Length - Offset, Offset);
+
+    if (Count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+
+    if (Count <= 0)
+    {
+      break;
+    }
+
+    Offset += Count;
+  }
+
+  Buffer->Length = Offset;
+}
+
+static inline void CloseLoad(const i32 File, const buffer_access Access, buffer *Buffer)
+{
+  ReleaseFileAccess(File, Access);
+  close(File);
+
+  if (Buffer->Length == 0)
+  {
+    SysFree(Buffer->Data);
+    *Buffer = ZeroLengthBuffer();
+  }
+}
+
+static inline bool32 CreateLoadRing(load_ring *Ring, const u32 Entries)
+{
+  io_uring_params Parameters;
+  memset(&Parameters, 0, sizeof(Parameters));
+
+  Ring->File = i32(syscall(__NR_io_uring_setup, Entries, &Parameters));
+
+  if (Ring->File < 0)
+  {
+    return false;
+  }
+
+  Ring->Entries = Parameters.sq_entries;
+  Ring->SubmitRingSize = Parameters.sq_off.array + Parameters.sq_entries * sizeof(u32);
+  Ring->CompleteRingSize =
+      Parameters.cq_off.cqes + Parameters.cq_entries * sizeof(io_uring_cqe);
+  Ring->SubmissionsSize = Parameters.sq_entries * sizeof(io_uring_sqe);
+
+  bool32 SingleMapping = HasFlag(Parameters.features, IORING_FEAT_SINGLE_MMAP);
+
+  if (SingleMapping)
+  {
+    Ring->SubmitRingSize = Ring->SubmitRingSize > Ring->CompleteRingSize
+                               ? Ring->SubmitRingSize
+                               : Ring->CompleteRingSize;
+    Ring->CompleteRingSize = Ring->SubmitRingSize;
+  }
+
+  Ring->SubmitRing = mmap(0x0, Ring->SubmitRingSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, Ring->File, IORING_OFF_SQ_RING);
+  Ring->CompleteRing = SingleMapping ? Ring->SubmitRing
+                                     : mmap(0x0, Ring->CompleteRingSize, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, Ring->File,
+                                            IORING_OFF_CQ_RING);
+  Ring->Submissions =
+      (io_uring_sqe *)mmap(0x0, Ring->SubmissionsSize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, Ring->File, IORING_OFF_SQES);
+
+  if (Ring->SubmitRing == MAP_FAILED || Ring->CompleteRing == MAP_FAILED ||
+      Ring->Submissions == MAP_FAILED)
+  {
+    if (Ring->SubmitRing != MAP_FAILED)
+    {
+      munmap(Ring->SubmitRing, Ring->SubmitRingSize);
+    }
+
+    if (!SingleMapping && Ring->CompleteRing != MAP_FAILED)
+    {
+      munmap(Ring->CompleteRing, Ring->CompleteRingSize);
+    }
+
+    if (Ring->Submissions != MAP_FAILED)
+    {
+      munmap(Ring->Submissions, Ring->SubmissionsSize);
+    }
+
+    close(Ring->File);
+    return false;
+  }
+
+  byte *Submit = (byte *)Ring->SubmitRing;
+  Ring->SubmitHead = (u32 *)(Submit + Parameters.sq_off.head);
+  Ring->SubmitTail = (u32 *)(Submit + Parameters.sq_off.tail);
+  Ring->SubmitMask = (u32 *)(Submit + Parameters.sq_off.ring_mask);
+  Ring->SubmitArray = (u32 *)(Submit + Parameters.sq_off.array);
+
+  byte *Complete = (byte *)Ring->CompleteRing;
+  Ring->CompleteHead = (u32 *)(Complete + Parameters.cq_off.head);
+  Ring->CompleteTail = (u32 *)(Complete + Parameters.cq_off.tail);
+  Ring->CompleteMask = (u32 *)(Complete + Parameters.cq_off.ring_mask);
+  Ring->Completions = (io_uring_cqe *)(Complete + Parameters.cq_off.cqes);
+
+  return true;
+}
+
+static inline void DestroyLoadRing(load_ring *Ring)
+{
+  munmap(Ring->Submissions, Ring->SubmissionsSize);
+
+  if (Ring->CompleteRing != Ring->SubmitRing)
+  {
+    munmap(Ring->CompleteRing, Ring->CompleteRingSize);
+  }
+
+  munmap(Ring->SubmitRing, Ring->SubmitRingSize);
+  close(Ring->File);
+}
+
+static inline void QueueRead(load_ring *Ring, const key Index, const i32 File,
+                             const buffer Buffer, const key Offset)
+{
+  // only this thread writes the tail, the kernel publishes the head
+  u32 Tail = *Ring->SubmitTail;
+  u32 Slot = Tail & *Ring->SubmitMask;
+  key Length = Buffer.Length - Offset;
+
+  io_uring_sqe *Submission = &Ring->Submissions[Slot];
+  memset(Submission, 0, sizeof(io_uring_sqe));
+  Submission->opcode = IORING_OP_READ;
+  Submission->fd = File;
+  Submission->addr = u64((byte *)Buffer.Data + Offset);
+  Submission->len = u32(Length < __BUFFER__MAX_READ ? Length : __BUFFER__MAX_READ);
+  Submission->off = Offset;
+  Submission->user_data = Index;
+
+  Ring->SubmitArray[Slot] = Slot;
+  __atomic_store_n(Ring->SubmitTail, Tail + 1, __ATOMIC_RELEASE);
+}
+
+static inline key LoadWithRing(load_ring *Ring, const key Count, const char **Paths,
+                               buffer *Buffers, const buffer_access Access,
+                               buffer_load_callback Callback, void *User)
+{
+  i32 *Files = SysAllocate(i32, Count);
+  key *Offsets = SysAllocate(key, Count);
+  key Next = 0;
+  key InFlight = 0;
+  key Pending = 0;
+  key Loaded = 0;
+
+  while (Next < Count || InFlight)
+  {
+    while (Next < Count && InFlight < Ring->Entries)
+    {
+      Files[Next] = OpenLoad(Paths[Next], Access, &Buffers[Next]);
+
+      if (Files[Next] < 0)
+      {
+        if (Callback)
+        {
+          Callback(User, Next, Buffers[Next]);
+        }
+      }
+      else
+      {
+        QueueRead(Ring, Next, Files[Next], Buffers[Next], 0);
+        InFlight++;
+        Pending++;
+      }
+
+      Next++;
+    }
+
+    if (!InFlight)
+    {
+      continue;
+    }
+
+    i32 Submitted = i32(syscall(__NR_io_uring_enter, Ring->File, u32(Pending), 1,
+                                IORING_ENTER_GETEVENTS, 0x0, 0));
+
+    if (Submitted < 0)
+    {
+      Assert((errno == EINTR || errno == EAGAIN || errno == EBUSY), "io_uring_enter failed.");
+    }
+    else
+    {
+      Pending -= Submitted;
+    }
+
+    u32 Head = *Ring->CompleteHead;
+    u32 Tail = __atomic_load_n(Ring->CompleteTail, __ATOMIC_ACQUIRE);
+
+    for (; Head != Tail; Head++)
+    {
+      io_uring_cqe *Completion = &Ring->Completions[Head & *Ring->CompleteMask];
+      key Index = Completion->user_data;
+      i32 Result = Completion->res;
+
+      if (Result > 0 && Offsets[Index] + Result < Buffers[Index].Length)
+      {
+        // short read, the rest goes back in the queue and keeps its in flight slot
+        Offsets[Index] += Result;
+        QueueRead(Ring, Index, Files[Index], Buffers[Index], Offsets[Index]);
+        Pending++;
+        continue;
+      }
+
+      if (Result >= 0)
+      {
+        Buffers[Index].Length = Offsets[Index] + Result;
+      }
+      else
+      {
+        // kernels without IORING_OP_READ land here too, finish the file the blocking way
+        ReadRemaining(Files[Index], &Buffers[Index], Offsets[Index]);
+      }
+
+      CloseLoad(Files[Index], Access, &Buffers[Index]);
+      InFlight--;
+      Loaded += IsInitialized(Buffers[Index]) ? 1 : 0;
+
+      if (Callback)
+      {
+        Callback(User, Index, Buffers[Index]);
+      }
+    }
+
+    __atomic_store_n(Ring->CompleteHead, Head, __ATOMIC_RELEASE);
+  }
+
+  SysFree(Offsets);
+  SysFree(Files);
+
+  return Loaded;
+}
+
+static void *LoadWorker(void *Parameter)
+{
+  load_batch *Batch = (load_batch *)Parameter;
+
+  for (;;)
+  {
+    key Index = __atomic_fetch_add(&Batch->Next, 1, __ATOMIC_RELAXED);
+
+    if (Index >= Batch->Count)
+    {
+      break;
+    }
+
+    buffer *Buffer = &Batch->Buffers[Index];
+    i32 File = OpenLoad(Batch->Paths[Index], Batch->Access, Buffer);
+
+    if (File >= 0)
+    {
+      ReadRemaining(File, Buffer, 0);
+      CloseLoad(File, Batch->Access, Buffer);
+    }
+
+    pthread_mutex_lock(&Batch->Mutex);
+    Batch->Completed[Batch->CompletedCount++] = Index;
+    pthread_cond_signal(&Batch->Condition);
+    pthread_mutex_unlock(&Batch->Mutex);
+  }
+
+  return 0x0;
+}
+
+static inline key LoadWithWorkers(const key Count, const char **Paths, buffer *Buffers,
+                                  const buffer_access Access, buffer_load_callback Callback,
+                                  void *User)
+{
+  load_batch Batch;
+  Batch.Count = Count;
+  Batch.Paths = Paths;
+  Batch.Buffers = Buffers;
+  Batch.Access = Access;
+  Batch.Next = 0;
+  Batch.Completed = SysAllocate(key, Count);
+  Batch.CompletedCount = 0;
+  pthread_mutex_init(&Batch.Mutex, 0x0);
+  pthread_cond_init(&Batch.Condition, 0x0);
+
+  key WorkerCount = sysconf(_SC_NPROCESSORS_ONLN);
+  WorkerCount = WorkerCount < __BUFFER__MAX_WORKERS ? WorkerCount : __BUFFER__MAX_WORKERS;
+  WorkerCount = WorkerCount < Count ? WorkerCount : Count;
+
+  pthread_t Workers[__BUFFER__MAX_WORKERS];
+  key Started = 0;
+
+  for (; Started < WorkerCount; Started++)
+  {
+    if (pthread_create(&Workers[Started], 0x0, LoadWorker, &Batch) != 0)
+    {
+      break;
+    }
+  }
+
+  if (Started == 0)
+  {
+    LoadWorker(&Batch);
+  }
+
+  // callbacks run here, on the calling thread, in completion order
+  key Reported = 0;
+  key Loaded = 0;
+
+  while (Reported < Count)
+  {
+    pthread_mutex_lock(&Batch.Mutex);
+
+    while (Batch.CompletedCount == Reported)
+    {
+      pthread_cond_wait(&Batch.Condition, &Batch.Mutex);
+    }
+
+    key Completed = Batch.CompletedCount;
+    pthread_mutex_unlock(&Batch.Mutex);
+
+    for (; Reported < Completed; Reported++)
+    {
+      key Index = Batch.Completed[Reported];
+      Loaded += IsInitialized(Buffers[Index]) ? 1 : 0;
+
+      if (Callback)
+      {
+        Callback(User, Index, Buffers[Index]);
+      }
+    }
+  }
+
+  for (key Index = 0; Index < Started; Index++)
+  {
+    pthread_join(Workers[Index], 0x0);
+  }
+
+  pthread_cond_destroy(&Batch.Condition);
+  pthread_mutex_destroy(&Batch.Mutex);
+  SysFree(Batch.Completed);
+
+  return Loaded;
+}
+
+key LoadBuffersFromFiles(const key Count, const char **Paths, buffer *Buffers,
+                         const buffer_access Access, buffer_load_callback Callback, void *User)
+{
+  if (Count == 0)
+  {
+    return 0;
+  }
+
+  load_ring Ring;
+  u32 Entries = Count < __BUFFER__RING_ENTRIES ? u32(Count) : __BUFFER__RING_ENTRIES;
+
+  if (CreateLoadRing(&Ring, Entries))
+  {
+    key Loaded = LoadWithRing(&Ring, Count, Paths, Buffers, Access, Callback, User);
+    DestroyLoadRing(&Ring);
+
+    return Loaded;
+  }
+
+  return LoadWithWorkers(Count, Paths, Buffers, Access, Callback, User);
+}
+
+key LoadBuffersFromFiles(const key Count, const char **Paths, buffer *Buffers,
+                         buffer_load_callback Callback, void *User)
+{
+  return LoadBuffersFromFiles(Count, Paths, Buffers, BUFFER_ACCESS_NORMAL, Callback, User);
+}
+
+key LoadBuffersFromFiles(const key Count, const char **Paths, buffer *Buffers)
+{
+  return LoadBuffersFromFiles(Count, Paths, Buffers, BUFFER_ACCESS_NORMAL, 0x0, 0x0);
+}
+
+// writes every vector, picking up after short writes, Vectors is consumed in the process
+static inline bool32 WriteVectors(const i32 File, iovec *Vectors, i32 Count)
+{
+  while (Count > 0)
+  {
+    ssize_t Written = writev(File, Vectors, Count < __BUFFER__MAX_VECTORS ? Count
+                                                                         : __BUFFER__MAX_VECTORS);
+
+    if (Written < 0 && errno == EINTR)
+    {
+      continue;
+    }
+
+    if (Written < 0)
+    {
+      return false;
+    }
+
+    while (Count > 0 && key(Written) >= Vectors->iov_len)
+    {
+      Written -= Vectors->iov_len;
+      Vectors++;
+      Count--;
+    }
+
+    if (Count > 0)
+    {
+      Vectors->iov_base = (byte *)Vectors->iov_base + Written;
+      Vectors->iov_len -= Written;
+    }
+  }
+
+  return true;
+}
+
+buffer_writer OpenBufferWriter(const char *Path, const key Size, const key Flags)
+{
+  buffer_writer Output = {
+      .Staging = ZeroLengthBuffer(),
+      .Filled = 0,
+      .File = -1,
+      .Flags = Flags,
+      .Failed = true,
+  };
+
+  key Length = (Size + __BUFFER__DIRECT_ALIGN - 1) & ~key(__BUFFER__DIRECT_ALIGN - 1);
+  i32 OpenFlags = O_WRONLY | O_CREAT | O_TRUNC;
+
+  if (HasFlag(Flags, BUFFER_WRITER_FLAG_DIRECT))
+  {
+    Output.File = open(Path, OpenFlags | O_DIRECT, 0644);
+
+    // tmpfs and friends refuse O_DIRECT, keep going through the page cache
+    if (Output.File < 0 && errno == EINVAL)
+    {
+      Output.Flags &= ~key(BUFFER_WRITER_FLAG_DIRECT);
+    }
+  }
+
+  if (Output.File < 0)
+  {
+    Output.File = open(Path, OpenFlags, 0644);
+  }
+
+  if (Output.File < 0 || Length == 0)
+  {
+    return Output;
+  }
+
+  void *Staging = mmap(0x0, Length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (Staging == MAP_FAILED)
+  {
+    close(Output.File);
+    Output.File = -1;
+    return Output;
+  }
+
+  Output.Staging = {.Length = Length, .Data = Staging};
+  Output.Failed = false;
+
+  return Output;
+}
+
+buffer_writer OpenBufferWriter(const char *Path, const key Size)
+{
+  return OpenBufferWriter(Path, Size, BUFFER_WRITER_FLAG_NONE);
+}
+
+// Direct writes only flush whole blocks, the tail stays staged until more data or the close.
+bool32 FlushBufferWriter(buffer_writer *Writer)
+{
+  if (Writer->Failed || Writer->Filled == 0)
+  {
+    return !Writer->Failed;
+  }
+
+  key Length = Writer->Filled;
+
+  if (HasFlag(Writer->Flags, BUFFER_WRITER_FLAG_DIRECT))
+  {
+    Length &= ~key(__BUFFER__DIRECT_ALIGN - 1);
+  }
+
+  iovec Vector = {.iov_base = Writer->Staging.Data, .iov_len = Length};
+
+  if (!WriteVectors(Writer->File, &Vector, 1))
+  {
+    Writer->Failed = true;
+    return false;
+  }
+
+  byte *Staging = (byte *)Writer->Staging.Data;
+  memmove(Staging, Staging + Length, Writer->Filled - Length);
+  Writer->Filled -= Length;
+
+  return true;
+}
+
+static inline bool32 StageBuffer(buffer_writer *Writer, const void *Source, const key N)
+{
+  const byte *Data = (const byte *)Source;
+  key Left = N;
+
+  while (Left)
+  {
+    if (Writer->Filled == Writer->Staging.Length && !FlushBufferWriter(Writer))
+    {
+      return false;
+    }
+
+    key Room = Writer->Staging.Length - Writer->Filled;
+    key Copy = Left < Room ? Left : Room;
+    memcpy((byte *)Writer->Staging.Data + Writer->Filled, Data, Copy);
+    Writer->Filled += Copy;
+    Data += Copy;
+    Left -= Copy;
+  }
+
+  return true;
+}
+
+bool32 WriteBuffers(buffer_writer *Writer, const key Count, const buffer *Buffers)
+{
+  if (Writer->Failed)
+  {
+    return false;
+  }
+
+  key Total = 0;
+
+  for (key Index = 0; Index < Count; Index++)
+  {
+    Total += Buffers[Index].Length;
+  }
+
+  // what fits is copied, direct writes can't take unaligned user memory either
+  if (Total <= Writer->Staging.Length - Writer->Filled ||
+      HasFlag(Writer->Flags, BUFFER_WRITER_FLAG_DIRECT))
+  {
+    for (key Index = 0; Index < Count; Index++)
+    {
+      if (!StageBuffer(Writer, Buffers[Index].Data, Buffers[Index].Length))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // staged bytes go first so everything lands in order, in a single writev when it can
+  iovec Vectors[__BUFFER__MAX_VECTORS];
+  i32 VectorCount = 0;
+
+  if (Writer->Filled)
+  {
+    Vectors[VectorCount++] = {.iov_base = Writer->Staging.Data, .iov_len = Writer->Filled};
+  }
+
+  for (key Index = 0; Index < Count; Index++)
+  {
+    if (Buffers[Index].Length == 0)
+    {
+      continue;
+    }
+
+    if (VectorCount == __BUFFER__MAX_VECTORS)
+    {
+      if (!WriteVectors(Writer->File, Vectors, VectorCount))
+      {
+        Writer->Failed = true;
+        return false;
+      }
+
+      VectorCount = 0;
+    }
+
+    Vectors[VectorCount++] = {.iov_base = Buffers[Index].Data, .iov_len = Buffers[Index].Length};
+  }
+
+  if (!WriteVectors(Writer->File, Vectors, VectorCount))
+  {
+    Writer->Failed = true;
+    return false;
+  }
+
+  Writer->Filled = 0;
+
+  return true;
+}
+
+bool32 _WriteBuffer(buffer_writer *Writer, const void *Source, const key N)
+{
+  buffer Buffer = {.Length = N, .Data = (void *)Source};
+  return WriteBuffers(Writer, 1, &Buffer);
+}
+
+bool32 CloseBufferWriter(buffer_writer *Writer)
+{
+  FlushBufferWriter(Writer);
+
+  // the unaligned tail of a direct write goes out through the page cache
+  if (!Writer->Failed && Writer->Filled)
+  {
+    fcntl(Writer->File, F_SETFL, fcntl(Writer->File, F_GETFL) & ~O_DIRECT);
+    Writer->Flags &= ~key(BUFFER_WRITER_FLAG_DIRECT);
+    FlushBufferWriter(Writer);
+  }
+
+  if (Writer->File >= 0 && close(Writer->File) != 0)
+  {
+    Writer->Failed = true;
+  }
+
+  if (IsInitialized(Writer->Staging))
+  {
+    munmap(Writer->Staging.Data, Writer->Staging.Length);
+  }
+
+  Writer->File = -1;
+  Writer->Staging = ZeroLengthBuffer();
+
+  return !Writer->Failed;
+}
+
+bool32 WriteFileFromBuffers(const key Count, const buffer *Buffers, const char *Path)
+{
+  buffer_writer Writer = OpenBufferWriter(Path, __BUFFER__WRITE_STAGING);
+  WriteBuffers(&Writer, Count, Buffers);
+
+  return CloseBufferWriter(&Writer);
+}
+
+bool32 WriteFileFromBuffer(const buffer Buffer, const char *Path)
+{
+  return WriteFileFromBuffers(1, &Buffer, Path);
+}
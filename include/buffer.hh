@@ -19,10 +19,21 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include "common.hh"
+#include "allocators/allocator.hh"
+#include "span.hh"
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 
+// linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define __BUFFER__READ_CHUNK (64 * 1024)
+
 struct buffer
 {
   key Length;
@@ -55,6 +66,16 @@ inline buffer AllocateBuffer(const key Length)
   };
 }
 
+template <typename A> inline buffer AllocateBuffer(A *Allocator, const key Length)
+{
+  Assert(Length > 0, "Request data allocation of 0 bytes.");
+
+  return {
+      .Length = Length,
+      .Data = AllocateN(Allocator, byte, Length),
+  };
+}
+
 inline void FreeBuffer(const buffer Buffer)
 {
   Assert(IsInitialized(Buffer), "Buffer was already freed or not initialized.");
@@ -70,7 +91,45 @@ inline buffer_ptr BufferPointer(const buffer Buffer)
   };
 }
 
-inline buffer LoadBufferFromFile(const char *Path)
+enum buffer_access
+{
+  BUFFER_ACCESS_NORMAL = 0,
+  BUFFER_ACCESS_SEQUENTIAL = 1, // Read front to back once, readahead is doubled
+  BUFFER_ACCESS_RANDOM = 2,     // Sparse lookups, readahead is turned off
+  BUFFER_ACCESS_WILLNEED = 3,   // Needed soon, the kernel starts reading in the background
+  BUFFER_ACCESS_DONTNEED = 4,   // Read once and dropped from the page cache after, for bulk jobs
+};
+
+// Hint for a file about to be read, DONTNEED reads like SEQUENTIAL until ReleaseFileAccess.
+inline void AdviseFileAccess(const i32 File, const buffer_access Access)
+{
+  switch (Access)
+  {
+  case BUFFER_ACCESS_SEQUENTIAL:
+  case BUFFER_ACCESS_DONTNEED:
+    posix_fadvise(File, 0, 0, POSIX_FADV_SEQUENTIAL);
+    break;
+  case BUFFER_ACCESS_RANDOM:
+    posix_fadvise(File, 0, 0, POSIX_FADV_RANDOM);
+    break;
+  case BUFFER_ACCESS_WILLNEED:
+    posix_fadvise(File, 0, 0, POSIX_FADV_WILLNEED);
+    break;
+  default:
+    break;
+  };
+}
+
+// Called once the file was read, drops its cached pages when nothing will read it again.
+inline void ReleaseFileAccess(const i32 File, const buffer_access Access)
+{
+  if (Access == BUFFER_ACCESS_DONTNEED)
+  {
+    posix_fadvise(File, 0, 0, POSIX_FADV_DONTNEED);
+  }
+}
+
+inline buffer LoadBufferFromFile(const char *Path, const buffer_access Access)
 {
   FILE *File = fopen(Path, "r");
 
@@ -78,11 +137,13 @@ inline buffer LoadBufferFromFile(const char *Path)
   {
     buffer Result;
 
+    AdviseFileAccess(fileno(File), Access);
     fseek(File, 0, SEEK_END);
     Result.Length = ftell(File);
     Result.Data = SysAllocate(byte, Result.Length);
     rewind(File);
     fread(Result.Data, 1, Result.Length, File);
+    ReleaseFileAccess(fileno(File), Access);
 
     fclose(File);
 
@@ -94,21 +155,204 @@ inline buffer LoadBufferFromFile(const char *Path)
   }
 }
 
-inline bool32 WriteFileFromBuffer(const buffer Buffer, const char *Path)
+inline buffer LoadBufferFromFile(const char *Path)
+{
+  return LoadBufferFromFile(Path, BUFFER_ACCESS_NORMAL);
+}
+
+template <typename A>
+inline buffer LoadBufferFromFile(A *Allocator, const char *Path, const buffer_access Access)
 {
-  FILE *File = fopen(Path, "w");
+  FILE *File = fopen(Path, "r");
 
-  if (File)
+  if (!File)
+  {
+    return ZeroLengthBuffer();
+  }
+
+  buffer Result;
+
+  AdviseFileAccess(fileno(File), Access);
+  fseek(File, 0, SEEK_END);
+  Result.Length = ftell(File);
+  Result.Data = AllocateN(Allocator, byte, Result.Length);
+  rewind(File);
+
+  if (!Result.Data)
   {
-    fwrite(Buffer.Data, 1, Buffer.Length, File);
     fclose(File);
+    return ZeroLengthBuffer();
+  }
 
-    return true;
+  fread(Result.Data, 1, Result.Length, File);
+  ReleaseFileAccess(fileno(File), Access);
+  fclose(File);
+
+  return Result;
+}
+
+template <typename A> inline buffer LoadBufferFromFile(A *Allocator, const char *Path)
+{
+  return LoadBufferFromFile(Allocator, Path, BUFFER_ACCESS_NORMAL);
+}
+
+// Read path for files that can't be mapped (pipes, procfs, ...), the data still lands in an
+// anonymous mapping so UnmapBuffer doesn't have to know which path was taken.
+inline buffer ReadBufferIntoMapping(const i32 File)
+{
+  key Capacity = __BUFFER__READ_CHUNK;
+  key Length = 0;
+  byte *Data = (byte *)mmap(0x0, Capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                            -1, 0);
+
+  if (Data == MAP_FAILED)
+  {
+    return ZeroLengthBuffer();
   }
 
-  return false;
+  for (;;)
+  {
+    if (Length == Capacity)
+    {
+      void *Grown = mremap(Data, Capacity, Capacity * 2, MREMAP_MAYMOVE);
+
+      if (Grown == MAP_FAILED)
+      {
+        munmap(Data, Capacity);
+        return ZeroLengthBuffer();
+      }
+
+      Data = (byte *)Grown;
+      Capacity *= 2;
+    }
+
+    ssize_t Count = read(File, Data + Length, Capacity - Length);
+
+    if (Count < 0)
+    {
+      munmap(Data, Capacity);
+      return ZeroLengthBuffer();
+    }
+
+    if (Count == 0)
+    {
+      break;
+    }
+
+    Length += Count;
+  }
+
+  if (Length == 0)
+  {
+    munmap(Data, Capacity);
+    return ZeroLengthBuffer();
+  }
+
+  // trim to the pages that hold data so munmap with Length releases all of it
+  key PageSize = sysconf(_SC_PAGESIZE);
+  key Used = (Length + PageSize - 1) & ~(PageSize - 1);
+
+  if (Used < Capacity)
+  {
+    munmap(Data + Used, Capacity - Used);
+  }
+
+  mprotect(Data, Used, PROT_READ);
+
+  return {
+      .Length = Length,
+      .Data = Data,
+  };
+}
+
+// Hint for memory returned by MapBufferFromFile. DONTNEED marks the pages already read as the first
+// to reclaim, MADV_DONTNEED would zero the anonymous mapping pipes and procfs files are read into.
+inline void AdviseBuffer(const buffer Buffer, const buffer_access Access)
+{
+  switch (Access)
+  {
+  case BUFFER_ACCESS_SEQUENTIAL:
+    madvise(Buffer.Data, Buffer.Length, MADV_SEQUENTIAL);
+    break;
+  case BUFFER_ACCESS_RANDOM:
+    madvise(Buffer.Data, Buffer.Length, MADV_RANDOM);
+    break;
+  case BUFFER_ACCESS_WILLNEED:
+    madvise(Buffer.Data, Buffer.Length, MADV_WILLNEED);
+    break;
+  case BUFFER_ACCESS_DONTNEED:
+    madvise(Buffer.Data, Buffer.Length, MADV_COLD);
+    break;
+  default:
+    madvise(Buffer.Data, Buffer.Length, MADV_NORMAL);
+    break;
+  };
+}
+
+// Read only view of the file straight from the page cache, nothing is allocated or copied.
+// The buffer must be released with UnmapBuffer, never FreeBuffer. A DONTNEED mapping is read
+// sequentially so the kernel can reclaim pages behind the reader.
+inline buffer MapBufferFromFile(const char *Path, const buffer_access Access)
+{
+  i32 File = open(Path, O_RDONLY);
+
+  if (File < 0)
+  {
+    return ZeroLengthBuffer();
+  }
+
+  AdviseFileAccess(File, Access);
+
+  buffer Result = ZeroLengthBuffer();
+  struct stat Status;
+
+  if (fstat(File, &Status) == 0 && S_ISREG(Status.st_mode) && Status.st_size > 0)
+  {
+    void *Data = mmap(0x0, Status.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+
+    if (Data != MAP_FAILED)
+    {
+      Result = {.Length = key(Status.st_size), .Data = Data};
+      AdviseBuffer(Result, Access == BUFFER_ACCESS_DONTNEED ? BUFFER_ACCESS_SEQUENTIAL : Access);
+    }
+  }
+
+  if (!IsInitialized(Result))
+  {
+    Result = ReadBufferIntoMapping(File);
+    ReleaseFileAccess(File, Access);
+  }
+
+  close(File);
+
+  return Result;
+}
+
+inline buffer MapBufferFromFile(const char *Path)
+{
+  return MapBufferFromFile(Path, BUFFER_ACCESS_NORMAL);
+}
+
+inline void UnmapBuffer(const buffer Buffer)
+{
+  Assert(IsInitialized(Buffer), "Buffer was already unmapped or not initialized.");
+
+  munmap(Buffer.Data, Buffer.Length);
 }
 
+// Called once per path as its load finishes, Buffer is zero length when the file couldn't be read.
+typedef void (*buffer_load_callback)(void *User, const key Index, const buffer Buffer);
+
+// Reads every file concurrently into Buffers, allocated with SysAllocate and released with
+// FreeBuffer. Reads go through io_uring when the kernel allows it and a pool of worker threads
+// otherwise, either way Callback runs on the calling thread in completion order so decoding
+// overlaps the reads still in flight. Returns the number of files loaded. Defined in buffer.cc.
+key LoadBuffersFromFiles(const key Count, const char **Paths, buffer *Buffers,
+                         const buffer_access Access, buffer_load_callback Callback, void *User);
+key LoadBuffersFromFiles(const key Count, const char **Paths, buffer *Buffers,
+                         buffer_load_callback Callback, void *User);
+key LoadBuffersFromFiles(const key Count, const char **Paths, buffer *Buffers);
+
 inline void *_ReadBuffer(buffer_ptr *Ptr, key N)
 {
   Assert(Ptr->Buffer.Length >= Ptr->Offset + N, "Buffer reading went out of bounds.");
@@ -121,6 +365,12 @@ inline void *_ReadBuffer(buffer_ptr *Ptr, key N)
 
 #define ReadBuffer(_Ptr, _Type, _N) (_Type *)_ReadBuffer(_Ptr, sizeof(_Type) * _N)
 
+// One bounds check for the next N bytes, decoded afterwards with the unchecked span readers.
+inline span ReadSpan(buffer_ptr *Ptr, const key N)
+{
+  return Span(N, _ReadBuffer(Ptr, N));
+}
+
 inline void _WriteBuffer(buffer_ptr *Ptr, void *Source, key N)
 {
   Assert(Ptr->Buffer.Length >= Ptr->Offset + N, "Buffer writing went out of bounds.");
@@ -130,3 +380,217 @@ inline void _WriteBuffer(buffer_ptr *Ptr, void *Source, key N)
 }
 
 #define WriteBuffer(_Ptr, _Source, _Type, _N) _WriteBuffer(_Ptr, _Source, sizeof(_Type) * _N)
+
+// Reader over a file descriptor through a fixed size window, so inputs of any size are read in
+// constant memory. Pointers handed out stay valid until the next call that can refill the window.
+struct buffer_stream
+{
+  buffer Window;
+  key Offset;
+  key Filled;
+  key Position; // file offset of the start of the window
+  i32 File;
+  bool32 EndOfFile;
+  buffer_access Access;
+};
+
+inline buffer_stream BufferStream(const i32 File, const key WindowSize)
+{
+  return {
+      .Window = AllocateBuffer(WindowSize),
+      .Offset = 0,
+      .Filled = 0,
+      .Position = 0,
+      .File = File,
+      .EndOfFile = File < 0,
+      .Access = BUFFER_ACCESS_NORMAL,
+  };
+}
+
+inline buffer_stream OpenBufferStream(const char *Path, const key WindowSize,
+                                      const buffer_access Access)
+{
+  i32 File = open(Path, O_RDONLY);
+
+  if (File >= 0)
+  {
+    AdviseFileAccess(File, Access);
+  }
+
+  buffer_stream Result = BufferStream(File, WindowSize);
+  Result.Access = Access;
+
+  return Result;
+}
+
+inline buffer_stream OpenBufferStream(const char *Path, const key WindowSize)
+{
+  return OpenBufferStream(Path, WindowSize, BUFFER_ACCESS_SEQUENTIAL);
+}
+
+inline void CloseBufferStream(buffer_stream *Stream)
+{
+  if (Stream->File >= 0)
+  {
+    ReleaseFileAccess(Stream->File, Stream->Access);
+    close(Stream->File);
+  }
+
+  FreeBuffer(Stream->Window);
+  Stream->File = -1;
+}
+
+inline bool32 IsInitialized(const buffer_stream *Stream)
+{
+  return Stream->File >= 0 && IsInitialized(Stream->Window);
+}
+
+inline key StreamOffset(const buffer_stream *Stream)
+{
+  return Stream->Position + Stream->Offset;
+}
+
+// Makes at least N bytes readable at the current offset, false when the input ends first.
+inline bool32 EnsureBuffer(buffer_stream *Stream, const key N)
+{
+  Assert(N <= Stream->Window.Length, "Buffer stream window is smaller than the request.");
+
+  if (Stream->Filled - Stream->Offset >= N)
+  {
+    return true;
+  }
+
+  // slide the unread tail to the front and top the window up behind it
+  byte *Window = (byte *)Stream->Window.Data;
+  key Remaining = Stream->Filled - Stream->Offset;
+  memmove(Window, Window + Stream->Offset, Remaining);
+  Stream->Position += Stream->Offset;
+  Stream->Offset = 0;
+  Stream->Filled = Remaining;
+
+  while (Stream->Filled < N && !Stream->EndOfFile)
+  {
+    ssize_t Count = read(Stream->File, Window + Stream->Filled,
+                         Stream->Window.Length - Stream->Filled);
+
+    if (Count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+
+    if (Count <= 0)
+    {
+      Stream->EndOfFile = true;
+      break;
+    }
+
+    Stream->Filled += Count;
+  }
+
+  return Stream->Filled >= N;
+}
+
+inline void *_PeekBuffer(buffer_stream *Stream, const key N)
+{
+  if (!EnsureBuffer(Stream, N))
+  {
+    return 0x0;
+  }
+
+  return (byte *)Stream->Window.Data + Stream->Offset;
+}
+
+#define PeekBuffer(_Ptr, _Type, _N) (_Type *)_PeekBuffer(_Ptr, sizeof(_Type) * _N)
+
+// Unlike the in memory reader, running out of input returns 0x0 instead of asserting.
+inline void *_ReadBuffer(buffer_stream *Stream, const key N)
+{
+  void *Result = _PeekBuffer(Stream, N);
+
+  if (Result)
+  {
+    Stream->Offset += N;
+  }
+
+  return Result;
+}
+
+// Skips N bytes without going through the window when they aren't loaded yet.
+inline bool32 SkipBuffer(buffer_stream *Stream, const key N)
+{
+  key Loaded = Stream->Filled - Stream->Offset;
+
+  if (N <= Loaded)
+  {
+    Stream->Offset += N;
+    return true;
+  }
+
+  key Target = StreamOffset(Stream) + N;
+  struct stat Status;
+
+  if (fstat(Stream->File, &Status) != 0 || !S_ISREG(Status.st_mode))
+  {
+    // pipes can't seek, read through the window instead
+    for (key Skipped = 0; Skipped < N;)
+    {
+      key Step = N - Skipped < Stream->Window.Length ? N - Skipped : Stream->Window.Length;
+
+      if (!_ReadBuffer(Stream, Step))
+      {
+        return false;
+      }
+
+      Skipped += Step;
+    }
+
+    return true;
+  }
+
+  // the descriptor sits at the end of the window, which is not where the stream started when
+  // it was handed an already opened file, so seek relative to it past the bytes still loaded
+  off_t Current = lseek(Stream->File, 0, SEEK_CUR);
+  key Remaining = N - Loaded;
+
+  if (Current < 0 || key(Current) + Remaining > key(Status.st_size) ||
+      lseek(Stream->File, Remaining, SEEK_CUR) < 0)
+  {
+    Stream->EndOfFile = true;
+    return false;
+  }
+
+  Stream->Position = Target;
+  Stream->Offset = 0;
+  Stream->Filled = 0;
+
+  return true;
+}
+
+enum buffer_writer_flag
+{
+  BUFFER_WRITER_FLAG_NONE = 0,
+  BUFFER_WRITER_FLAG_DIRECT = 0b1, // Bypass the page cache with O_DIRECT, for large outputs
+};
+
+// Writer that coalesces small writes in a page aligned staging buffer and flushes it with writev
+// along with any large buffer that doesn't need the copy. Defined in buffer.cc.
+struct buffer_writer
+{
+  buffer Staging;
+  key Filled;
+  i32 File;
+  key Flags;
+  bool32 Failed;
+};
+
+buffer_writer OpenBufferWriter(const char *Path, const key Size);
+buffer_writer OpenBufferWriter(const char *Path, const key Size, const key Flags);
+bool32 _WriteBuffer(buffer_writer *Writer, const void *Source, const key N);
+bool32 WriteBuffers(buffer_writer *Writer, const key Count, const buffer *Buffers);
+bool32 FlushBufferWriter(buffer_writer *Writer);
+bool32 CloseBufferWriter(buffer_writer *Writer);
+
+// Writes the buffers to Path in order through a buffer_writer. Defined in buffer.cc like the
+// writer, programs calling these link include/buffer.cc and -lpthread.
+bool32 WriteFileFromBuffers(const key Count, const buffer *Buffers, const char *Path);
+bool32 WriteFileFromBuffer(const buffer Buffer, const char *Path);
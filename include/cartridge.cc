@@ -19,19 +19,13 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "cartridge.hh"
 #include "hash.hh"
 
-#define __CRPK__BUFFER_SIZE 2048
+#define __CRPK__BUFFER_SIZE (64 * 1024)
 #define __CRPK__Offset(_Ptr, _N) ((byte *)_Ptr + _N)
-#define __CRPK__SEED_ID 0x014F65CB
-#define __CRPK__SEED_HASH 0xD49EE70C
 
-u64 IDString(const char *AssetFile)
+void IDAndHashString(const char *AssetFile, u64 *ID, u64 *Hash)
 {
-  return hash::Mix(__CRPK__SEED_ID, AssetFile);
-}
-
-u64 HashString(const char *AssetFile)
-{
-  return hash::Mix(__CRPK__SEED_HASH, AssetFile);
+  hash::MixDual(__CRPK__SEED_ID, __CRPK__SEED_HASH, AssetFile, __builtin_strlen(AssetFile), ID,
+                Hash);
 }
 
 crpk::block *GetBlockWithID(crpk::block *Blocks, key Length, u64 Hash, u64 ID)
@@ -40,9 +34,11 @@ crpk::block *GetBlockWithID(crpk::block *Blocks, key Length, u64 Hash, u64 ID)
   crpk::block *Block = Blocks + Index;
   key Count = 0;
 
+  // the block table is stored as is in the cartridge, so it stays a packed linear probe and only
+  // the first step pays for a division
   while (Block->ID != ID)
   {
-    Index = (Index + 1) % Length;
+    Index = Index + 1 == Length ? 0 : Index + 1;
     Block = Blocks + Index;
     Count++;
 
@@ -143,8 +139,16 @@ crpk::cartridge *crpk::Unpack(void *CartridgeData)
 
 crpk::buffer crpk::GetKeyData(crpk::cartridge *Cartridge, const char *AssetFile)
 {
-  u64 Hash = HashString(AssetFile), ID = IDString(AssetFile);
-  crpk::block *Block = GetBlockWithID(Cartridge->Blocks, Cartridge->Header.BlockCount, Hash, ID);
+  crpk::asset_key Key;
+  IDAndHashString(AssetFile, &Key.ID, &Key.Hash);
+
+  return crpk::GetKeyData(Cartridge, Key);
+}
+
+crpk::buffer crpk::GetKeyData(crpk::cartridge *Cartridge, const crpk::asset_key Key)
+{
+  crpk::block *Block =
+      GetBlockWithID(Cartridge->Blocks, Cartridge->Header.BlockCount, Key.Hash, Key.ID);
 
   if (Block)
   {
@@ -174,14 +178,21 @@ crpk::code crpk::Package(key Length, const char **InputFiles, const char *Output
   key Offset = 0;
   crpk::block *Blocks = (crpk::block *)__CRPK__Allocate(sizeof(crpk::block) * Length);
 
+  // both digests of every path in a single pass over each one
+  u64 *IDs = (u64 *)__CRPK__Allocate(sizeof(u64) * Length * 2);
+  u64 *Hashes = IDs + Length;
+  hash::MixBatch(__CRPK__SEED_ID, __CRPK__SEED_HASH, InputFiles, 0x0, Length, IDs, Hashes);
+
   for (key Index = 0; Index < Length; Index++)
   {
     const char *InputFile = InputFiles[Index];
-    u64 ID = IDString(InputFile), Hash = HashString(InputFile);
+    u64 ID = IDs[Index], Hash = Hashes[Index];
     crpk::block *Block = GetEmptyHashIndex(Blocks, Length, Hash);
 
     if (!Block)
     {
+      __CRPK__Free(IDs);
+      __CRPK__Free(Blocks);
       return Index + 1;
     }
 
@@ -189,12 +200,16 @@ crpk::code crpk::Package(key Length, const char **InputFiles, const char *Output
 
     if (!Asset)
     {
+      __CRPK__Free(IDs);
+      __CRPK__Free(Blocks);
       return Index + 1;
     }
 
     if (__CRPK__Seek(Asset, 0, __CRPK__seek_end))
     {
       __CRPK__Close(Asset);
+      __CRPK__Free(IDs);
+      __CRPK__Free(Blocks);
       return Index + 1;
     }
 
@@ -209,6 +224,7 @@ crpk::code crpk::Package(key Length, const char **InputFiles, const char *Output
     Offset += FileLength;
   }
 
+  __CRPK__Free(IDs);
   Header.DataSize = Offset;
 
   __CRPK__file *CartridgeOutput = __CRPK__Open(Output, "wb");
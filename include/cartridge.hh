@@ -19,6 +19,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include "common.hh"
+#include "hash.hh"
 
 //
 #ifndef __CRPK__Allocate
@@ -51,9 +52,11 @@ namespace crpk
 typedef i32 code;
 
 #define __CRPK__CRPK_EXTENSION_LENGTH 4
-#define __CRPK__VERSION 1
+#define __CRPK__VERSION 2
 
 #define __CRPK__CODE FourCC('c', 'r', 'p', 'k')
+#define __CRPK__SEED_ID 0x014F65CB
+#define __CRPK__SEED_HASH 0xD49EE70C
 
 enum return_code
 {
@@ -93,7 +96,27 @@ struct buffer
   byte *Data;
 };
 
+// Both block digests of an asset path, CrpkKey("path") hashes a literal at compile time.
+struct asset_key
+{
+  u64 ID;
+  u64 Hash;
+};
+
+constexpr inline crpk::asset_key AssetKey(const char *AssetFile)
+{
+  return {
+      .ID = hash::Mix(__CRPK__SEED_ID, AssetFile),
+      .Hash = hash::Mix(__CRPK__SEED_HASH, AssetFile),
+  };
+}
+
+#define CrpkKey(_AssetFile)                                                                        \
+  (crpk::asset_key{HashKeySeeded(__CRPK__SEED_ID, _AssetFile),                                     \
+                   HashKeySeeded(__CRPK__SEED_HASH, _AssetFile)})
+
 crpk::buffer GetKeyData(crpk::cartridge *Cartridge, const char *AssetFile);
+crpk::buffer GetKeyData(crpk::cartridge *Cartridge, const crpk::asset_key Key);
 
 crpk::code Package(key Length, const char **InputFiles, const char *Output);
 crpk::cartridge *Unpack(const char *CartridgeFile);
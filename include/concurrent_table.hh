@@ -0,0 +1,293 @@
+/*
+Concurrent hash map keyed by digest
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocators/allocator.hh"
+#include "common.hh"
+#include "hash.hh"
+
+// linux
+#include <pthread.h>
+
+#define __CONCURRENT__STRIPES 64
+#define __CONCURRENT__MIN_BUCKETS 64
+// chains average this many entries at most, past it the table was created too small
+#define __CONCURRENT__MAX_LOAD 4
+
+namespace hash
+{
+enum concurrent_state
+{
+  CONCURRENT_STATE_PENDING = 0,
+  CONCURRENT_STATE_READY = 1,
+  CONCURRENT_STATE_FAILED = 2,
+};
+
+// Key and Next never change once the entry is linked, Value is only read after State is READY.
+template <typename V> struct concurrent_entry
+{
+  hash::digest Key;
+  hash::concurrent_entry<V> *Next;
+  u32 State;
+  V Value;
+};
+
+struct concurrent_stripe
+{
+  pthread_mutex_t Lock;
+  pthread_cond_t Ready;
+};
+
+// Chained buckets, only the chains grow. Lookups walk the chains without locking, inserts take the
+// lock of one of __CONCURRENT__STRIPES stripes and link a fully built entry at the head of its
+// bucket. Entries are never unlinked so a reader can't see one go away, the table is emptied by
+// destroying it along with the allocator its entries came from.
+//
+// The bucket count is fixed at creation from ExpectedCount, resizing would relink entries under
+// readers that walk the chains without a lock. Size it for every key it will hold, e.g. the block
+// count of a cartridge, past __CONCURRENT__MAX_LOAD entries per bucket new keys are refused.
+//
+// Keys are expected to be digests already, e.g. crpk::AssetKey(Path).ID, their low bits pick the
+// bucket. The allocator is called from several threads at once and must be safe for it, like
+// atomic_bump.
+template <typename V, typename A> struct concurrent_table
+{
+  A *Allocator;
+  hash::concurrent_entry<V> **Buckets;
+  key BucketMask;
+  key Count;
+  hash::concurrent_stripe Stripes[__CONCURRENT__STRIPES];
+};
+
+template <typename V, typename A>
+hash::concurrent_table<V, A> *CreateConcurrentTable(A *Allocator, const key ExpectedCount)
+{
+  key BucketCount = __CONCURRENT__MIN_BUCKETS;
+
+  while (BucketCount < ExpectedCount)
+  {
+    BucketCount <<= 1;
+  }
+
+  typedef hash::concurrent_table<V, A> table;
+  table *Output = SysAllocate(table, 1);
+  hash::concurrent_entry<V> **Buckets = SysAllocate(hash::concurrent_entry<V> *, BucketCount);
+
+  if (!Output || !Buckets)
+  {
+    SysFree(Output);
+    SysFree(Buckets);
+    return 0x0;
+  }
+
+  Output->Allocator = Allocator;
+  Output->Buckets = Buckets;
+  Output->BucketMask = BucketCount - 1;
+  Output->Count = 0;
+
+  for (key Index = 0; Index < __CONCURRENT__STRIPES; Index++)
+  {
+    pthread_mutex_init(&Output->Stripes[Index].Lock, 0x0);
+    pthread_cond_init(&Output->Stripes[Index].Ready, 0x0);
+  }
+
+  return Output;
+}
+
+// Must not race with any other call on the table.
+template <typename V, typename A> void Destroy(hash::concurrent_table<V, A> *Table)
+{
+  for (key Index = 0; Index < __CONCURRENT__STRIPES; Index++)
+  {
+    pthread_mutex_destroy(&Table->Stripes[Index].Lock);
+    pthread_cond_destroy(&Table->Stripes[Index].Ready);
+  }
+
+  SysFree(Table->Buckets);
+  SysFree(Table);
+}
+
+template <typename V, typename A>
+inline hash::concurrent_stripe *GetStripe(hash::concurrent_table<V, A> *Table,
+                                          const hash::digest Key)
+{
+  return &Table->Stripes[(Key & Table->BucketMask) % __CONCURRENT__STRIPES];
+}
+
+template <typename V, typename A>
+hash::concurrent_entry<V> *FindEntry(const hash::concurrent_table<V, A> *Table,
+                                     const hash::digest Key)
+{
+  hash::concurrent_entry<V> *Entry =
+      __atomic_load_n(&Table->Buckets[Key & Table->BucketMask], __ATOMIC_ACQUIRE);
+
+  while (Entry && Entry->Key != Key)
+  {
+    Entry = Entry->Next;
+  }
+
+  return Entry;
+}
+
+// Lock free, 0x0 while the value is missing, still being produced or was abandoned.
+template <typename V, typename A>
+V *Find(const hash::concurrent_table<V, A> *Table, const hash::digest Key)
+{
+  hash::concurrent_entry<V> *Entry = hash::FindEntry(Table, Key);
+
+  if (Entry && __atomic_load_n(&Entry->State, __ATOMIC_ACQUIRE) == CONCURRENT_STATE_READY)
+  {
+    return &Entry->Value;
+  }
+
+  return 0x0;
+}
+
+// Insert if absent. Exactly one caller per key gets Claimed set, it then produces the value and
+// hands it over with Publish, or Abandon when it couldn't. Everyone else gets the same entry and
+// can Wait on it. 0x0 when the key is missing and the table is already at __CONCURRENT__MAX_LOAD
+// keys per bucket, or the allocator returned 0x0, nothing is claimed then.
+template <typename V, typename A>
+hash::concurrent_entry<V> *Claim(hash::concurrent_table<V, A> *Table, const hash::digest Key,
+                                 bool32 *Claimed)
+{
+  *Claimed = false;
+  hash::concurrent_entry<V> *Entry = hash::FindEntry(Table, Key);
+
+  if (Entry)
+  {
+    return Entry;
+  }
+
+  hash::concurrent_stripe *Stripe = hash::GetStripe(Table, Key);
+  pthread_mutex_lock(&Stripe->Lock);
+
+  // another thread may have linked it between the lookup and the lock
+  hash::concurrent_entry<V> **Bucket = &Table->Buckets[Key & Table->BucketMask];
+  hash::concurrent_entry<V> *Head = *Bucket;
+
+  for (Entry = Head; Entry && Entry->Key != Key; Entry = Entry->Next)
+  {
+  }
+
+  if (!Entry)
+  {
+    // the slot is reserved before allocating since inserts on other stripes count concurrently
+    key Count = __atomic_add_fetch(&Table->Count, 1, __ATOMIC_RELAXED);
+
+    if (Count <= (Table->BucketMask + 1) * __CONCURRENT__MAX_LOAD)
+    {
+      Entry = Allocate(Table->Allocator, hash::concurrent_entry<V>);
+    }
+
+    if (Entry)
+    {
+      Entry->Key = Key;
+      Entry->Next = Head;
+      Entry->State = CONCURRENT_STATE_PENDING;
+      __atomic_store_n(Bucket, Entry, __ATOMIC_RELEASE);
+      *Claimed = true;
+    }
+    else
+    {
+      __atomic_sub_fetch(&Table->Count, 1, __ATOMIC_RELAXED);
+    }
+  }
+
+  pthread_mutex_unlock(&Stripe->Lock);
+
+  return Entry;
+}
+
+template <typename V, typename A>
+void Finish(hash::concurrent_table<V, A> *Table, hash::concurrent_entry<V> *Entry,
+            const u32 State)
+{
+  // under the lock so a waiter can't check State and miss the wake up
+  hash::concurrent_stripe *Stripe = hash::GetStripe(Table, Entry->Key);
+  pthread_mutex_lock(&Stripe->Lock);
+  __atomic_store_n(&Entry->State, State, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&Stripe->Ready);
+  pthread_mutex_unlock(&Stripe->Lock);
+}
+
+template <typename V, typename A>
+void Publish(hash::concurrent_table<V, A> *Table, hash::concurrent_entry<V> *Entry,
+             const V Value)
+{
+  Entry->Value = Value;
+  hash::Finish(Table, Entry, CONCURRENT_STATE_READY);
+}
+
+// The key stays taken, Find and Wait return 0x0 for it from then on.
+template <typename V, typename A>
+void Abandon(hash::concurrent_table<V, A> *Table, hash::concurrent_entry<V> *Entry)
+{
+  hash::Finish(Table, Entry, CONCURRENT_STATE_FAILED);
+}
+
+// Blocks until the claiming thread publishes or abandons the entry.
+template <typename V, typename A>
+V *Wait(hash::concurrent_table<V, A> *Table, hash::concurrent_entry<V> *Entry)
+{
+  u32 State = __atomic_load_n(&Entry->State, __ATOMIC_ACQUIRE);
+
+  if (State == CONCURRENT_STATE_PENDING)
+  {
+    hash::concurrent_stripe *Stripe = hash::GetStripe(Table, Entry->Key);
+    pthread_mutex_lock(&Stripe->Lock);
+
+    while ((State = __atomic_load_n(&Entry->State, __ATOMIC_ACQUIRE)) ==
+           CONCURRENT_STATE_PENDING)
+    {
+      pthread_cond_wait(&Stripe->Ready, &Stripe->Lock);
+    }
+
+    pthread_mutex_unlock(&Stripe->Lock);
+  }
+
+  return State == CONCURRENT_STATE_READY ? &Entry->Value : 0x0;
+}
+
+// Insert if absent for values that are cheap to make, returns whichever value won. 0x0 when Claim
+// refused the key or the entry was abandoned.
+template <typename V, typename A>
+V *Insert(hash::concurrent_table<V, A> *Table, const hash::digest Key, const V Value)
+{
+  bool32 Claimed;
+  hash::concurrent_entry<V> *Entry = hash::Claim(Table, Key, &Claimed);
+
+  if (!Entry)
+  {
+    return 0x0;
+  }
+
+  if (Claimed)
+  {
+    hash::Publish(Table, Entry, Value);
+  }
+
+  return hash::Wait(Table, Entry);
+}
+
+template <typename V, typename A> key Count(const hash::concurrent_table<V, A> *Table)
+{
+  return __atomic_load_n(&Table->Count, __ATOMIC_RELAXED);
+}
+}; // namespace hash
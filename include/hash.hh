@@ -20,71 +20,155 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <common.hh>
 
+// libc
+#include <string.h>
+
+// linux
+#include <pthread.h>
+
 namespace hash
 {
 typedef u64 digest;
-// SOURCE: taken from stb_ds
-// Copyright (c) 2019 Sean Barrett
-// Permission is hereby granted, free of charge, to any person obtaining a copy of
-// this software and associated documentation files (the "Software"), to deal in
-// the Software without restriction, including without limitation the rights to
-// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
-// of the Software, and to permit persons to whom the Software is furnished to do
-// so, subject to the following conditions:
-// The above copyright notice and this permission notice shall be included in all
-// copies or substantial portions of the Software.
-// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-// SOFTWARE.
+
 #define __HASH__DEFAULT_SEED 0xD49EE70C
-#define __HASH__SIZE_T_BITS ((sizeof(u32)) * 8)
-#define __HASH__ROTATE_LEFT(val, n) (((val) << (n)) | ((val) >> (__HASH__SIZE_T_BITS - (n))))
-#define __HASH__ROTATE_RIGHT(val, n) (((val) >> (n)) | ((val) << (__HASH__SIZE_T_BITS - (n))))
 
-// Thomas Wang 64 bit to 32 bit
-constexpr inline hash::digest Mix(const hash::digest Seed, const u32 Value)
+// SOURCE: string hash adapted from wyhash final 4 by Wang Yi, released into the public domain
+#define __HASH__SECRET_0 0xa0761d6478bd642full
+#define __HASH__SECRET_1 0xe7037ed1a0b428dbull
+#define __HASH__SECRET_2 0x8ebc6af09c88c6e3ull
+#define __HASH__SECRET_3 0x589965cc75374cc3ull
+
+// Loads are spelled out byte by byte so they stay usable in constant expressions, compilers merge
+// them into a single little endian load at runtime.
+constexpr inline u64 Read64(const char *String)
 {
-  hash::digest Result = Value;
-  Result ^= Seed;
-  Result = (~Result) + (Result << 18);
-  Result ^= Result ^ __HASH__ROTATE_RIGHT(Result, 31);
-  Result = Result * 21;
-  Result ^= Result ^ __HASH__ROTATE_RIGHT(Result, 11);
-  Result += (Result << 6);
-  Result ^= __HASH__ROTATE_RIGHT(Result, 22);
-  return Result + Seed;
+  return u64(u8(String[0])) | u64(u8(String[1])) << 8 | u64(u8(String[2])) << 16 |
+         u64(u8(String[3])) << 24 | u64(u8(String[4])) << 32 | u64(u8(String[5])) << 40 |
+         u64(u8(String[6])) << 48 | u64(u8(String[7])) << 56;
 }
 
-constexpr inline hash::digest Mix(const u32 Value)
+constexpr inline u64 Read32(const char *String)
 {
-  return hash::Mix(__HASH__DEFAULT_SEED, Value);
+  return u64(u8(String[0])) | u64(u8(String[1])) << 8 | u64(u8(String[2])) << 16 |
+         u64(u8(String[3])) << 24;
 }
 
-constexpr inline hash::digest Mix(const hash::digest Seed, const char *String)
+// 1 to 3 bytes, first, middle and last so every byte counts
+constexpr inline u64 Read3(const char *String, const key Length)
+{
+  return u64(u8(String[0])) << 16 | u64(u8(String[Length >> 1])) << 8 |
+         u64(u8(String[Length - 1]));
+}
+
+// Full 64x64 to 128 bit multiply folded back to 64 bits, every input bit reaches every output bit.
+constexpr inline u64 Fold(const u64 A, const u64 B)
+{
+  return u64((unsigned __int128)A * B) ^ u64(((unsigned __int128)A * B) >> 64);
+}
+
+constexpr inline u64 MixSeed(const hash::digest Seed)
 {
-  hash::digest Result = Seed;
-  while (*String)
+  return Seed ^ hash::Fold(Seed ^ __HASH__SECRET_0, __HASH__SECRET_1);
+}
+
+constexpr inline u64 MixStep(const u64 State, const char *Cursor)
+{
+  return hash::Fold(hash::Read64(Cursor) ^ __HASH__SECRET_1, hash::Read64(Cursor + 8) ^ State);
+}
+
+// 48 bytes over three independent lanes
+constexpr inline void MixBlock(u64 *State, u64 *Lane1, u64 *Lane2, const char *Cursor)
+{
+  *State = hash::MixStep(*State, Cursor);
+  *Lane1 = hash::Fold(hash::Read64(Cursor + 16) ^ __HASH__SECRET_2,
+                      hash::Read64(Cursor + 24) ^ *Lane1);
+  *Lane2 = hash::Fold(hash::Read64(Cursor + 32) ^ __HASH__SECRET_3,
+                      hash::Read64(Cursor + 40) ^ *Lane2);
+}
+
+// Reads the last 16 bytes, or the whole key when it is that short, and folds them with State.
+// Cursor and Left are where the block loops stopped.
+constexpr inline hash::digest MixTail(const u64 State, const char *String, const key Length,
+                                      const char *Cursor, const key Left)
+{
+  u64 A = 0, B = 0;
+
+  if (Length <= 16)
+  {
+    if (Length >= 4)
+    {
+      key Middle = (Length >> 3) << 2;
+      A = (hash::Read32(String) << 32) | hash::Read32(String + Middle);
+      B = (hash::Read32(String + Length - 4) << 32) | hash::Read32(String + Length - 4 - Middle);
+    }
+    else if (Length > 0)
+    {
+      A = hash::Read3(String, Length);
+    }
+  }
+  else
   {
-    Result = __HASH__ROTATE_LEFT(Result, 9) + (unsigned char)*String++;
+    // overlaps what was already consumed when the tail is short
+    A = hash::Read64(Cursor + Left - 16);
+    B = hash::Read64(Cursor + Left - 8);
   }
 
-  return hash::Mix(Result) + Seed;
+  A ^= __HASH__SECRET_1;
+  B ^= State;
+  unsigned __int128 Product = (unsigned __int128)A * B;
+  A = u64(Product);
+  B = u64(Product >> 64);
+
+  return hash::Fold(A ^ __HASH__SECRET_0 ^ Length, B ^ __HASH__SECRET_1);
 }
 
+// Two folded multiplies, a single one leaves the top input bits barely mixed.
+constexpr inline hash::digest Mix(const hash::digest Seed, const u32 Value)
+{
+  u64 Result = hash::Fold(Value ^ Seed ^ __HASH__SECRET_0, __HASH__SECRET_1);
+  return hash::Fold(Result ^ __HASH__SECRET_2, __HASH__SECRET_3);
+}
+
+constexpr inline hash::digest Mix(const u32 Value)
+{
+  return hash::Mix(__HASH__DEFAULT_SEED, Value);
+}
+
+// Hashes 16 bytes per step, 48 with three independent lanes past that, and finishes with a
+// folded multiply so the full 64 bits of the digest are mixed.
 constexpr inline hash::digest Mix(const hash::digest Seed, const char *String, const key Length)
 {
-  hash::digest Result = Seed;
+  u64 State = hash::MixSeed(Seed);
+  const char *Cursor = String;
+  key Left = Length;
 
-  for (key CharIndex = 0; CharIndex < Length; CharIndex++)
+  if (Left > 48)
   {
-    Result = __HASH__ROTATE_LEFT(Result, 9) + (unsigned char)String[CharIndex];
+    u64 Lane1 = State, Lane2 = State;
+
+    do
+    {
+      hash::MixBlock(&State, &Lane1, &Lane2, Cursor);
+      Cursor += 48;
+      Left -= 48;
+    } while (Left > 48);
+
+    State ^= Lane1 ^ Lane2;
   }
 
-  return hash::Mix(Result) + Seed;
+  while (Left > 16)
+  {
+    State = hash::MixStep(State, Cursor);
+    Cursor += 16;
+    Left -= 16;
+  }
+
+  return hash::MixTail(State, String, Length, Cursor, Left);
+}
+
+constexpr inline hash::digest Mix(const hash::digest Seed, const char *String)
+{
+  return hash::Mix(Seed, String, __builtin_strlen(String));
 }
 
 constexpr inline hash::digest Mix(const char *String)
@@ -96,11 +180,290 @@ constexpr inline hash::digest Mix(const char *String, const key Length)
 {
   return hash::Mix(__HASH__DEFAULT_SEED, String, Length);
 }
-/////////// End of stb_ds code ///////////
 
+// Digest held as a template argument, so it's always computed by the compiler. HashKey("name")
+// is a constant usable anywhere a runtime hash::Mix of the same string would be.
+template <hash::digest Value> struct constant
+{
+  static constexpr hash::digest Digest = Value;
+};
+
+#define HashKey(_String) (hash::constant<hash::Mix(_String)>::Digest)
+#define HashKeySeeded(_Seed, _String) (hash::constant<hash::Mix(_Seed, _String)>::Digest)
+
+// One pass over the key for two seeds, e.g. an ID and a probe hash. Loads and the length are
+// shared, the two multiply chains are independent so they overlap.
+inline void MixDual(const hash::digest SeedA, const hash::digest SeedB, const char *String,
+                    const key Length, hash::digest *OutputA, hash::digest *OutputB)
+{
+  u64 StateA = hash::MixSeed(SeedA);
+  u64 StateB = hash::MixSeed(SeedB);
+  const char *Cursor = String;
+  key Left = Length;
+
+  if (Left > 48)
+  {
+    u64 LaneA1 = StateA, LaneA2 = StateA, LaneB1 = StateB, LaneB2 = StateB;
+
+    do
+    {
+      u64 Word0 = hash::Read64(Cursor) ^ __HASH__SECRET_1, Word1 = hash::Read64(Cursor + 8);
+      u64 Word2 = hash::Read64(Cursor + 16) ^ __HASH__SECRET_2, Word3 = hash::Read64(Cursor + 24);
+      u64 Word4 = hash::Read64(Cursor + 32) ^ __HASH__SECRET_3, Word5 = hash::Read64(Cursor + 40);
+      StateA = hash::Fold(Word0, Word1 ^ StateA);
+      StateB = hash::Fold(Word0, Word1 ^ StateB);
+      LaneA1 = hash::Fold(Word2, Word3 ^ LaneA1);
+      LaneB1 = hash::Fold(Word2, Word3 ^ LaneB1);
+      LaneA2 = hash::Fold(Word4, Word5 ^ LaneA2);
+      LaneB2 = hash::Fold(Word4, Word5 ^ LaneB2);
+      Cursor += 48;
+      Left -= 48;
+    } while (Left > 48);
+
+    StateA ^= LaneA1 ^ LaneA2;
+    StateB ^= LaneB1 ^ LaneB2;
+  }
+
+  while (Left > 16)
+  {
+    u64 Word0 = hash::Read64(Cursor) ^ __HASH__SECRET_1, Word1 = hash::Read64(Cursor + 8);
+    StateA = hash::Fold(Word0, Word1 ^ StateA);
+    StateB = hash::Fold(Word0, Word1 ^ StateB);
+    Cursor += 16;
+    Left -= 16;
+  }
+
+  *OutputA = hash::MixTail(StateA, String, Length, Cursor, Left);
+  *OutputB = hash::MixTail(StateB, String, Length, Cursor, Left);
+}
+
+// Hashes Count keys, Lengths can be 0x0 for null terminated strings. Digests match hash::Mix.
+// Every key is an independent multiply chain, consecutive keys overlap in the pipeline.
+inline void MixBatch(const hash::digest Seed, const char **Strings, const key *Lengths,
+                     const key Count, hash::digest *Output)
+{
+  for (key Index = 0; Index < Count; Index++)
+  {
+    key Length = Lengths ? Lengths[Index] : __builtin_strlen(Strings[Index]);
+    Output[Index] = hash::Mix(Seed, Strings[Index], Length);
+  }
+}
+
+inline void MixBatch(const char **Strings, const key *Lengths, const key Count,
+                     hash::digest *Output)
+{
+  hash::MixBatch(__HASH__DEFAULT_SEED, Strings, Lengths, Count, Output);
+}
+
+inline void MixBatch(const hash::digest SeedA, const hash::digest SeedB, const char **Strings,
+                     const key *Lengths, const key Count, hash::digest *OutputA,
+                     hash::digest *OutputB)
+{
+  for (key Index = 0; Index < Count; Index++)
+  {
+    key Length = Lengths ? Lengths[Index] : __builtin_strlen(Strings[Index]);
+    hash::MixDual(SeedA, SeedB, Strings[Index], Length, &OutputA[Index], &OutputB[Index]);
+  }
+}
+
+// Incremental form of Mix for data that arrives in chunks, the digest matches hash::Mix over the
+// concatenated chunks whatever their sizes. The last 48 bytes are held back since Mix finishes
+// differently on them, along with the 16 before which the tail can reach back into.
+struct stream
+{
+  u64 State;
+  u64 Lane1;
+  u64 Lane2;
+  u64 Length;
+  key Buffered;
+  char Buffer[16 + 48];
+};
+
+inline hash::stream Stream(const hash::digest Seed)
+{
+  hash::stream Result = {};
+  Result.State = hash::MixSeed(Seed);
+  Result.Lane1 = Result.State;
+  Result.Lane2 = Result.State;
+
+  return Result;
+}
+
+inline hash::stream Stream()
+{
+  return hash::Stream(__HASH__DEFAULT_SEED);
+}
+
+inline void Update(hash::stream *Stream, const void *Data, key Length)
+{
+  const char *Input = (const char *)Data;
+  char *Pending = Stream->Buffer + 16;
+  Stream->Length += Length;
+
+  if (Stream->Buffered + Length <= 48)
+  {
+    memcpy(Pending + Stream->Buffered, Input, Length);
+    Stream->Buffered += Length;
+    return;
+  }
+
+  // more input follows the pending block, so it can be mixed
+  if (Stream->Buffered)
+  {
+    key Fill = 48 - Stream->Buffered;
+    memcpy(Pending + Stream->Buffered, Input, Fill);
+    Input += Fill;
+    Length -= Fill;
+
+    hash::MixBlock(&Stream->State, &Stream->Lane1, &Stream->Lane2, Pending);
+    memcpy(Stream->Buffer, Pending + 32, 16);
+    Stream->Buffered = 0;
+  }
+
+  if (Length > 48)
+  {
+    do
+    {
+      hash::MixBlock(&Stream->State, &Stream->Lane1, &Stream->Lane2, Input);
+      Input += 48;
+      Length -= 48;
+    } while (Length > 48);
+
+    memcpy(Stream->Buffer, Input - 16, 16);
+  }
+
+  memcpy(Pending, Input, Length);
+  Stream->Buffered = Length;
+}
+
+// Doesn't modify the stream, more data can still be added after.
+inline hash::digest Finalize(const hash::stream *Stream)
+{
+  u64 State = Stream->State;
+  const char *String = Stream->Buffer + 16;
+  const char *Cursor = String;
+  key Left = Stream->Buffered;
+
+  if (Stream->Length > 48)
+  {
+    State ^= Stream->Lane1 ^ Stream->Lane2;
+  }
+
+  while (Left > 16)
+  {
+    State = hash::MixStep(State, Cursor);
+    Cursor += 16;
+    Left -= 16;
+  }
+
+  return hash::MixTail(State, String, Stream->Length, Cursor, Left);
+}
+
+// Tree mode splits the input in leaves hashed on their own, the root is a stream over the leaf
+// digests in order. Inputs that fit in one leaf hash the same as hash::Mix.
+#define __HASH__TREE_LEAF_SIZE (1024 * 1024)
+#define __HASH__TREE_BATCH 256
+#define __HASH__TREE_MAX_THREADS 16
+
+struct tree_job
+{
+  hash::digest Seed;
+  const char *Data;
+  key Length;
+  key First;
+  key Last;
+  hash::digest *Leaves;
+};
+
+inline void *MixTreeLeaves(void *User)
+{
+  hash::tree_job *Job = (hash::tree_job *)User;
+
+  for (key Index = Job->First; Index < Job->Last; Index++)
+  {
+    key Offset = Index * __HASH__TREE_LEAF_SIZE;
+    key Length = Job->Length - Offset;
+    Length = Length < __HASH__TREE_LEAF_SIZE ? Length : __HASH__TREE_LEAF_SIZE;
+    Job->Leaves[Index % __HASH__TREE_BATCH] = hash::Mix(Job->Seed, Job->Data + Offset, Length);
+  }
+
+  return 0x0;
+}
+
+// ThreadCount includes the calling thread, leaves are hashed a batch at a time so nothing is
+// allocated. A thread that can't be started has its share run on the calling thread.
+inline hash::digest MixTree(const hash::digest Seed, const void *Data, const key Length,
+                            const u32 ThreadCount)
+{
+  const char *Input = (const char *)Data;
+
+  if (Length <= __HASH__TREE_LEAF_SIZE)
+  {
+    return hash::Mix(Seed, Input, Length);
+  }
+
+  key LeafCount = (Length + __HASH__TREE_LEAF_SIZE - 1) / __HASH__TREE_LEAF_SIZE;
+  key Threads = ThreadCount < __HASH__TREE_MAX_THREADS ? ThreadCount : __HASH__TREE_MAX_THREADS;
+  Threads = Threads ? Threads : 1;
+
+  hash::stream Root = hash::Stream(Seed ^ __HASH__SECRET_2);
+  hash::digest Leaves[__HASH__TREE_BATCH];
+  hash::tree_job Jobs[__HASH__TREE_MAX_THREADS];
+  pthread_t Workers[__HASH__TREE_MAX_THREADS];
+  bool32 Started[__HASH__TREE_MAX_THREADS];
+
+  for (key First = 0; First < LeafCount; First += __HASH__TREE_BATCH)
+  {
+    key Last = First + __HASH__TREE_BATCH < LeafCount ? First + __HASH__TREE_BATCH : LeafCount;
+    key Share = (Last - First + Threads - 1) / Threads;
+
+    for (key Thread = 0; Thread < Threads; Thread++)
+    {
+      key JobFirst = First + Share * Thread;
+      Jobs[Thread] = {
+          .Seed = Seed,
+          .Data = Input,
+          .Length = Length,
+          .First = JobFirst < Last ? JobFirst : Last,
+          .Last = JobFirst + Share < Last ? JobFirst + Share : Last,
+          .Leaves = Leaves,
+      };
+
+      Started[Thread] = Thread && Jobs[Thread].First < Jobs[Thread].Last &&
+                        !pthread_create(&Workers[Thread], 0x0, hash::MixTreeLeaves, &Jobs[Thread]);
+    }
+
+    for (key Thread = 0; Thread < Threads; Thread++)
+    {
+      if (!Started[Thread])
+      {
+        hash::MixTreeLeaves(&Jobs[Thread]);
+      }
+    }
+
+    for (key Thread = 1; Thread < Threads; Thread++)
+    {
+      if (Started[Thread])
+      {
+        pthread_join(Workers[Thread], 0x0);
+      }
+    }
+
+    hash::Update(&Root, Leaves, sizeof(hash::digest) * (Last - First));
+  }
+
+  return hash::Finalize(&Root);
+}
+
+inline hash::digest MixTree(const void *Data, const key Length, const u32 ThreadCount)
+{
+  return hash::MixTree(__HASH__DEFAULT_SEED, Data, Length, ThreadCount);
+}
+
+// computed in 64 bits, in 32 the pairs wrap and collide once X + Y passes 65535
 constexpr inline hash::digest CantorPair(const u32 X, const u32 Y)
 {
-  return (X + Y) * (X + Y + 1) / 2 + Y;
+  return (u64(X) + Y) * (u64(X) + Y + 1) / 2 + Y;
 }
 
 constexpr inline hash::digest CantorPairSigned(const i32 X, const i32 Y)
@@ -113,7 +476,7 @@ constexpr inline hash::digest CantorPairSigned(const i32 X, const i32 Y)
 
 constexpr inline hash::digest SzudzikPair(const u32 X, const u32 Y)
 {
-  return X >= Y ? (X * X) + X + Y : (Y * Y) + X;
+  return X >= Y ? (u64(X) * X) + X + Y : (u64(Y) * Y) + X;
 }
 
 constexpr inline hash::digest SzudzikPairSigned(const i32 X, const i32 Y)
@@ -0,0 +1,506 @@
+/*
+Open addressing hash table
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "allocators/allocator.hh"
+#include "common.hh"
+#include "hash.hh"
+
+// libc
+#include <string.h>
+
+// Control bytes, full slots hold the low 7 bits of their digest so the sign bit alone tells
+// empty and deleted slots apart from live ones.
+#define __TABLE__EMPTY i8(-128)
+#define __TABLE__DELETED i8(-2)
+
+#if defined(__SSE2__)
+// sse2
+#include <emmintrin.h>
+
+#define __TABLE__GROUP_WIDTH 16
+#define __TABLE__MASK_SHIFT 0
+#else
+#define __TABLE__GROUP_WIDTH 8
+#define __TABLE__MASK_SHIFT 3
+#define __TABLE__LSBS 0x0101010101010101ull
+#define __TABLE__MSBS 0x8080808080808080ull
+#endif
+
+namespace hash
+{
+// Bitmask of matching slots in a group, one bit per slot with SSE2 and the top bit of every byte
+// otherwise. Iterate with TableMaskFirst and Mask &= Mask - 1.
+#if defined(__SSE2__)
+typedef u32 table_mask;
+
+inline hash::table_mask TableMatch(const i8 *Control, const i8 Value)
+{
+  __m128i Group = _mm_loadu_si128((const __m128i *)Control);
+  return hash::table_mask(_mm_movemask_epi8(_mm_cmpeq_epi8(Group, _mm_set1_epi8(Value))));
+}
+
+inline hash::table_mask TableMatchEmpty(const i8 *Control)
+{
+  return hash::TableMatch(Control, __TABLE__EMPTY);
+}
+
+inline hash::table_mask TableMatchEmptyOrDeleted(const i8 *Control)
+{
+  return hash::table_mask(_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)Control)));
+}
+
+inline key TableMaskLast(const hash::table_mask Mask)
+{
+  return key(__builtin_clz(Mask) - (32 - __TABLE__GROUP_WIDTH));
+}
+#else
+typedef u64 table_mask;
+
+inline u64 TableLoad(const i8 *Control)
+{
+  u64 Group;
+  memcpy(&Group, Control, sizeof(Group));
+  return Group;
+}
+
+// can report a false positive next to a real match, keys are always compared after
+inline hash::table_mask TableMatch(const i8 *Control, const i8 Value)
+{
+  u64 Group = hash::TableLoad(Control) ^ (__TABLE__LSBS * u8(Value));
+  return (Group - __TABLE__LSBS) & ~Group & __TABLE__MSBS;
+}
+
+inline hash::table_mask TableMatchEmpty(const i8 *Control)
+{
+  u64 Group = hash::TableLoad(Control);
+  return Group & ~(Group << 6) & __TABLE__MSBS;
+}
+
+inline hash::table_mask TableMatchEmptyOrDeleted(const i8 *Control)
+{
+  u64 Group = hash::TableLoad(Control);
+  return Group & ~(Group << 7) & __TABLE__MSBS;
+}
+
+inline key TableMaskLast(const hash::table_mask Mask)
+{
+  return key(__builtin_clzll(Mask) >> __TABLE__MASK_SHIFT);
+}
+#endif
+
+inline key TableMaskFirst(const hash::table_mask Mask)
+{
+  return key(__builtin_ctzll(Mask) >> __TABLE__MASK_SHIFT);
+}
+
+// Keys are hashed through TableDigest, overload it next to a key type to use it in a table.
+inline hash::digest TableDigest(const u64 Key)
+{
+  u64 Result = hash::Fold(Key ^ __HASH__SECRET_0, __HASH__SECRET_1);
+  return hash::Fold(Result ^ __HASH__SECRET_2, __HASH__SECRET_3);
+}
+
+inline hash::digest TableDigest(const i64 Key)
+{
+  return hash::TableDigest(u64(Key));
+}
+
+inline hash::digest TableDigest(const u32 Key)
+{
+  return hash::TableDigest(u64(Key));
+}
+
+inline hash::digest TableDigest(const i32 Key)
+{
+  return hash::TableDigest(u64(u32(Key)));
+}
+
+template <typename K, typename V> struct table_slot
+{
+  K Key;
+  V Value;
+};
+
+// Swiss table style open addressing. Slots are probed a group of control bytes at a time, the
+// capacity is a power of two no smaller than a group and the first group of control bytes is
+// mirrored past the end so a group can be loaded at any slot. Keys and values are copied as is.
+// Storage comes from the allocator, when the table grows the old block is handed back to Free
+// for allocators that have one and left to Reset for the others. Tombstones are cleared in place
+// instead while the table is at most 25/32 full, so removing and inserting at a steady size never
+// allocates.
+template <typename K, typename V, typename A> struct table
+{
+  A *Allocator;
+  i8 *Control;
+  hash::table_slot<K, V> *Slots;
+  key Capacity;
+  key Count;
+  key Tombstones;
+};
+
+template <typename A>
+inline auto TableRelease(A *Allocator, void *Memory, int) -> decltype(Free(Allocator, Memory))
+{
+  // unqualified so allocator::Free is found by argument dependent lookup
+  Free(Allocator, Memory);
+}
+
+template <typename A> inline void TableRelease(A *, void *, long)
+{
+}
+
+// 7/8 of the slots can be filled, tombstones included
+inline key TableMaxLoad(const key Capacity)
+{
+  return Capacity - Capacity / 8;
+}
+
+inline key TableCapacity(const key Count)
+{
+  key Capacity = __TABLE__GROUP_WIDTH;
+
+  while (hash::TableMaxLoad(Capacity) < Count)
+  {
+    Capacity <<= 1;
+  }
+
+  return Capacity;
+}
+
+template <typename K, typename V, typename A>
+inline void TableSetControl(hash::table<K, V, A> *Table, const key Index, const i8 Value)
+{
+  Table->Control[Index] = Value;
+
+  if (Index < __TABLE__GROUP_WIDTH)
+  {
+    Table->Control[Table->Capacity + Index] = Value;
+  }
+}
+
+template <typename K, typename V, typename A>
+key TableFindIndex(const hash::table<K, V, A> *Table, const K Key, const hash::digest Digest)
+{
+  if (!Table->Capacity)
+  {
+    return KEY_MAX;
+  }
+
+  key Mask = Table->Capacity - 1;
+  key Position = (Digest >> 7) & Mask;
+  i8 Tag = i8(Digest & 0x7F);
+
+  // triangular steps over groups visit every group once when the capacity is a power of two
+  for (key Step = __TABLE__GROUP_WIDTH;; Step += __TABLE__GROUP_WIDTH)
+  {
+    const i8 *Group = Table->Control + Position;
+
+    for (hash::table_mask Match = hash::TableMatch(Group, Tag); Match; Match &= Match - 1)
+    {
+      key Index = (Position + hash::TableMaskFirst(Match)) & Mask;
+
+      if (Table->Slots[Index].Key == Key)
+      {
+        return Index;
+      }
+    }
+
+    if (hash::TableMatchEmpty(Group))
+    {
+      return KEY_MAX;
+    }
+
+    Position = (Position + Step) & Mask;
+  }
+}
+
+// First empty or deleted slot on the probe sequence of Digest.
+template <typename K, typename V, typename A>
+key TableFreeIndex(const hash::table<K, V, A> *Table, const hash::digest Digest)
+{
+  key Mask = Table->Capacity - 1;
+  key Position = (Digest >> 7) & Mask;
+
+  for (key Step = __TABLE__GROUP_WIDTH;; Step += __TABLE__GROUP_WIDTH)
+  {
+    hash::table_mask Available = hash::TableMatchEmptyOrDeleted(Table->Control + Position);
+
+    if (Available)
+    {
+      return (Position + hash::TableMaskFirst(Available)) & Mask;
+    }
+
+    Position = (Position + Step) & Mask;
+  }
+}
+
+template <typename K, typename V, typename A>
+bool32 TableRehash(hash::table<K, V, A> *Table, const key Capacity)
+{
+  key SlotSize = sizeof(hash::table_slot<K, V>) * Capacity;
+  key Size = SlotSize + Capacity + __TABLE__GROUP_WIDTH;
+  byte *Memory = (byte *)_Allocate(Table->Allocator, alignof(hash::table_slot<K, V>), Size);
+
+  if (!Memory)
+  {
+    return false;
+  }
+
+  hash::table<K, V, A> Old = *Table;
+  Table->Slots = (hash::table_slot<K, V> *)Memory;
+  Table->Control = (i8 *)(Memory + SlotSize);
+  Table->Capacity = Capacity;
+  Table->Tombstones = 0;
+  memset(Table->Control, __TABLE__EMPTY, Capacity + __TABLE__GROUP_WIDTH);
+
+  for (key Index = 0; Index < Old.Capacity; Index++)
+  {
+    if (Old.Control[Index] >= 0)
+    {
+      hash::table_slot<K, V> *Slot = &Old.Slots[Index];
+      hash::digest Digest = TableDigest(Slot->Key);
+      key Target = hash::TableFreeIndex(Table, Digest);
+      hash::TableSetControl(Table, Target, i8(Digest & 0x7F));
+      Table->Slots[Target] = *Slot;
+    }
+  }
+
+  if (Old.Slots)
+  {
+    hash::TableRelease(Table->Allocator, Old.Slots, 0);
+  }
+
+  return true;
+}
+
+// Clears the tombstones without allocating. Live slots are marked deleted and placed again one at
+// a time, either kept where they are when that is already the first group their probe reaches,
+// moved to an empty slot or swapped with a slot still waiting to be placed.
+template <typename K, typename V, typename A> void TableDropDeleted(hash::table<K, V, A> *Table)
+{
+  key Mask = Table->Capacity - 1;
+
+  for (key Index = 0; Index < Table->Capacity; Index++)
+  {
+    Table->Control[Index] = Table->Control[Index] >= 0 ? __TABLE__DELETED : __TABLE__EMPTY;
+  }
+
+  memcpy(Table->Control + Table->Capacity, Table->Control, __TABLE__GROUP_WIDTH);
+
+  for (key Index = 0; Index < Table->Capacity; Index++)
+  {
+    if (Table->Control[Index] != __TABLE__DELETED)
+    {
+      continue;
+    }
+
+    hash::table_slot<K, V> *Slot = &Table->Slots[Index];
+    hash::digest Digest = TableDigest(Slot->Key);
+    key Position = (Digest >> 7) & Mask;
+    key Target = hash::TableFreeIndex(Table, Digest);
+    i8 Tag = i8(Digest & 0x7F);
+
+    // groups of a probe start on multiples of the group width from its first position
+    if (((Target - Position) & Mask) / __TABLE__GROUP_WIDTH ==
+        ((Index - Position) & Mask) / __TABLE__GROUP_WIDTH)
+    {
+      hash::TableSetControl(Table, Index, Tag);
+    }
+    else if (Table->Control[Target] == __TABLE__EMPTY)
+    {
+      Table->Slots[Target] = *Slot;
+      hash::TableSetControl(Table, Target, Tag);
+      hash::TableSetControl(Table, Index, __TABLE__EMPTY);
+    }
+    else
+    {
+      hash::table_slot<K, V> Swap = Table->Slots[Target];
+      Table->Slots[Target] = *Slot;
+      *Slot = Swap;
+      hash::TableSetControl(Table, Target, Tag);
+
+      // the slot swapped in still has to be placed, wraps back to 0 from the first slot
+      Index--;
+    }
+  }
+
+  Table->Tombstones = 0;
+}
+
+// Nothing is allocated until the first insert when Count is 0.
+template <typename K, typename V, typename A>
+hash::table<K, V, A> Table(A *Allocator, const key Count)
+{
+  hash::table<K, V, A> Result = {
+      .Allocator = Allocator,
+      .Control = 0x0,
+      .Slots = 0x0,
+      .Capacity = 0,
+      .Count = 0,
+      .Tombstones = 0,
+  };
+
+  if (Count)
+  {
+    hash::TableRehash(&Result, hash::TableCapacity(Count));
+  }
+
+  return Result;
+}
+
+template <typename K, typename V, typename A>
+inline bool32 IsInitialized(const hash::table<K, V, A> *Table)
+{
+  return Table->Control != 0x0;
+}
+
+template <typename K, typename V, typename A>
+inline bool32 IsOccupied(const hash::table<K, V, A> *Table, const key Index)
+{
+  return Table->Control[Index] >= 0;
+}
+
+template <typename K, typename V, typename A>
+V *Find(const hash::table<K, V, A> *Table, const K Key)
+{
+  // unqualified so overloads next to the key type are found
+  key Index = hash::TableFindIndex(Table, Key, TableDigest(Key));
+  return Index != KEY_MAX ? &Table->Slots[Index].Value : 0x0;
+}
+
+// Returns the value of Key, a new zeroed one when it wasn't there. 0x0 when the table had to
+// grow and the allocator ran out.
+template <typename K, typename V, typename A>
+V *Insert(hash::table<K, V, A> *Table, const K Key, bool32 *Inserted)
+{
+  hash::digest Digest = TableDigest(Key);
+  key Index = hash::TableFindIndex(Table, Key, Digest);
+  *Inserted = false;
+
+  if (Index != KEY_MAX)
+  {
+    return &Table->Slots[Index].Value;
+  }
+
+  if (Table->Capacity)
+  {
+    Index = hash::TableFreeIndex(Table, Digest);
+  }
+
+  // reusing a tombstone doesn't add to the load
+  if (!Table->Capacity || (Table->Control[Index] == __TABLE__EMPTY &&
+                           Table->Count + Table->Tombstones >= hash::TableMaxLoad(Table->Capacity)))
+  {
+    // Grows well past the point where clearing tombstones would free enough slots, otherwise
+    // every few inserts after a remove near the max load would rehash again.
+    if (Table->Capacity > __TABLE__GROUP_WIDTH && Table->Count * 32 <= Table->Capacity * 25)
+    {
+      hash::TableDropDeleted(Table);
+    }
+    else if (!hash::TableRehash(Table, Table->Capacity ? Table->Capacity * 2
+                                                       : hash::TableCapacity(Table->Count + 1)))
+    {
+      return 0x0;
+    }
+
+    Index = hash::TableFreeIndex(Table, Digest);
+  }
+
+  Table->Tombstones -= Table->Control[Index] == __TABLE__DELETED ? 1 : 0;
+  Table->Count++;
+  hash::TableSetControl(Table, Index, i8(Digest & 0x7F));
+
+  hash::table_slot<K, V> *Slot = &Table->Slots[Index];
+  Slot->Key = Key;
+  Slot->Value = V();
+  *Inserted = true;
+
+  return &Slot->Value;
+}
+
+template <typename K, typename V, typename A>
+V *Insert(hash::table<K, V, A> *Table, const K Key, const V Value)
+{
+  bool32 Inserted;
+  V *Output = hash::Insert(Table, Key, &Inserted);
+
+  if (Output)
+  {
+    *Output = Value;
+  }
+
+  return Output;
+}
+
+template <typename K, typename V, typename A>
+bool32 Remove(hash::table<K, V, A> *Table, const K Key)
+{
+  key Index = hash::TableFindIndex(Table, Key, TableDigest(Key));
+
+  if (Index == KEY_MAX)
+  {
+    return false;
+  }
+
+  // A probe only walks past a group that was full. When the empty slots around Index leave no
+  // full group window across it, no probe ever continued past it and it can go back to empty.
+  key Mask = Table->Capacity - 1;
+  hash::table_mask EmptyBefore =
+      hash::TableMatchEmpty(Table->Control + ((Index - __TABLE__GROUP_WIDTH) & Mask));
+  hash::table_mask EmptyAfter = hash::TableMatchEmpty(Table->Control + Index);
+  bool32 NeverFull = EmptyBefore && EmptyAfter &&
+                     hash::TableMaskFirst(EmptyAfter) + hash::TableMaskLast(EmptyBefore) <
+                         __TABLE__GROUP_WIDTH;
+
+  hash::TableSetControl(Table, Index, NeverFull ? __TABLE__EMPTY : __TABLE__DELETED);
+  Table->Tombstones += NeverFull ? 0 : 1;
+  Table->Count--;
+
+  return true;
+}
+
+template <typename K, typename V, typename A>
+bool32 Reserve(hash::table<K, V, A> *Table, const key Count)
+{
+  key Capacity = hash::TableCapacity(Count);
+  return Capacity <= Table->Capacity || hash::TableRehash(Table, Capacity);
+}
+
+template <typename K, typename V, typename A> void Clear(hash::table<K, V, A> *Table)
+{
+  if (Table->Control)
+  {
+    memset(Table->Control, __TABLE__EMPTY, Table->Capacity + __TABLE__GROUP_WIDTH);
+  }
+
+  Table->Count = 0;
+  Table->Tombstones = 0;
+}
+
+template <typename K, typename V, typename A> void Destroy(hash::table<K, V, A> *Table)
+{
+  if (Table->Slots)
+  {
+    hash::TableRelease(Table->Allocator, Table->Slots, 0);
+  }
+
+  *Table = hash::Table<K, V>(Table->Allocator, 0);
+}
+}; // namespace hash
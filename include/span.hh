@@ -0,0 +1,238 @@
+/*
+Endian aware span reader
+Copyright (C) 2025  Vincent Lavoie
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "common.hh"
+
+#include <string.h>
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define __SPAN__LE16(_Value) (_Value)
+#define __SPAN__LE32(_Value) (_Value)
+#define __SPAN__BE16(_Value) __builtin_bswap16(_Value)
+#define __SPAN__BE32(_Value) __builtin_bswap32(_Value)
+#else
+#define __SPAN__LE16(_Value) __builtin_bswap16(_Value)
+#define __SPAN__LE32(_Value) __builtin_bswap32(_Value)
+#define __SPAN__BE16(_Value) (_Value)
+#define __SPAN__BE32(_Value) (_Value)
+#endif
+
+// Bytes left to decode. Bounds are checked once with HasSpan or ReadSpan for a whole run of
+// fields, the Read functions after that don't check anything.
+struct span
+{
+  const byte *Offset;
+  const byte *End;
+};
+
+inline span Span(const key Length, const void *Data)
+{
+  return {
+      .Offset = (const byte *)Data,
+      .End = (const byte *)Data + Length,
+  };
+}
+
+inline key SpanLength(const span *Span)
+{
+  return key(Span->End - Span->Offset);
+}
+
+inline bool32 HasSpan(const span *Span, const key N)
+{
+  return SpanLength(Span) >= N;
+}
+
+// Splits the next N bytes off into their own span.
+inline span ReadSpan(span *Span, const key N)
+{
+  Assert(HasSpan(Span, N), "Span reading went out of bounds.");
+
+  span Result = {.Offset = Span->Offset, .End = Span->Offset + N};
+  Span->Offset += N;
+
+  return Result;
+}
+
+inline void SkipSpan(span *Span, const key N)
+{
+  Span->Offset += N;
+}
+
+inline u8 Read8(span *Span)
+{
+  return *Span->Offset++;
+}
+
+inline u16 Read16LE(span *Span)
+{
+  u16 Result;
+  memcpy(&Result, Span->Offset, sizeof(Result));
+  Span->Offset += sizeof(Result);
+  return __SPAN__LE16(Result);
+}
+
+inline u16 Read16BE(span *Span)
+{
+  u16 Result;
+  memcpy(&Result, Span->Offset, sizeof(Result));
+  Span->Offset += sizeof(Result);
+  return __SPAN__BE16(Result);
+}
+
+inline u32 Read24LE(span *Span)
+{
+  u32 Result = u32(Span->Offset[2]) << 16 | u32(Span->Offset[1]) << 8 | u32(Span->Offset[0]);
+  Span->Offset += 3;
+  return Result;
+}
+
+inline u32 Read24BE(span *Span)
+{
+  u32 Result = u32(Span->Offset[0]) << 16 | u32(Span->Offset[1]) << 8 | u32(Span->Offset[2]);
+  Span->Offset += 3;
+  return Result;
+}
+
+inline u32 Read32LE(span *Span)
+{
+  u32 Result;
+  memcpy(&Result, Span->Offset, sizeof(Result));
+  Span->Offset += sizeof(Result);
+  return __SPAN__LE32(Result);
+}
+
+inline u32 Read32BE(span *Span)
+{
+  u32 Result;
+  memcpy(&Result, Span->Offset, sizeof(Result));
+  Span->Offset += sizeof(Result);
+  return __SPAN__BE32(Result);
+}
+
+inline f32 ReadF32LE(span *Span)
+{
+  u32 Bits = Read32LE(Span);
+  f32 Result;
+  memcpy(&Result, &Bits, sizeof(Result));
+  return Result;
+}
+
+inline f32 ReadF32BE(span *Span)
+{
+  u32 Bits = Read32BE(Span);
+  f32 Result;
+  memcpy(&Result, &Bits, sizeof(Result));
+  return Result;
+}
+
+// Array decoders, one bounds check up front and a branchless loop over a local pointer so the
+// byte swaps vectorize.
+#define __SPAN__READ_ARRAY(_Type, _Width, _Decode)                                                 \
+  Assert(HasSpan(Span, Count * _Width), "Span reading went out of bounds.");                       \
+  const byte *Input = Span->Offset;                                                                \
+  for (key Index = 0; Index < Count; Index++)                                                      \
+  {                                                                                                \
+    _Type Value;                                                                                   \
+    memcpy(&Value, Input + Index * _Width, sizeof(Value));                                         \
+    Output[Index] = _Decode(Value);                                                                \
+  }                                                                                                \
+  Span->Offset += Count * _Width;
+
+inline void Read16LE(span *Span, u16 *Output, const key Count)
+{
+  __SPAN__READ_ARRAY(u16, 2, __SPAN__LE16);
+}
+
+inline void Read16BE(span *Span, u16 *Output, const key Count)
+{
+  __SPAN__READ_ARRAY(u16, 2, __SPAN__BE16);
+}
+
+inline void Read24LE(span *Span, u32 *Output, const key Count)
+{
+  Assert(HasSpan(Span, Count * 3), "Span reading went out of bounds.");
+  const byte *Input = Span->Offset;
+
+  for (key Index = 0; Index < Count; Index++)
+  {
+    const byte *Value = Input + Index * 3;
+    Output[Index] = u32(Value[2]) << 16 | u32(Value[1]) << 8 | u32(Value[0]);
+  }
+
+  Span->Offset += Count * 3;
+}
+
+inline void Read24BE(span *Span, u32 *Output, const key Count)
+{
+  Assert(HasSpan(Span, Count * 3), "Span reading went out of bounds.");
+  const byte *Input = Span->Offset;
+
+  for (key Index = 0; Index < Count; Index++)
+  {
+    const byte *Value = Input + Index * 3;
+    Output[Index] = u32(Value[0]) << 16 | u32(Value[1]) << 8 | u32(Value[2]);
+  }
+
+  Span->Offset += Count * 3;
+}
+
+inline void Read32LE(span *Span, u32 *Output, const key Count)
+{
+  __SPAN__READ_ARRAY(u32, 4, __SPAN__LE32);
+}
+
+inline void Read32BE(span *Span, u32 *Output, const key Count)
+{
+  __SPAN__READ_ARRAY(u32, 4, __SPAN__BE32);
+}
+
+// floats are swapped as integers and copied bit for bit
+inline void ReadF32LE(span *Span, f32 *Output, const key Count)
+{
+  Assert(HasSpan(Span, Count * 4), "Span reading went out of bounds.");
+  const byte *Input = Span->Offset;
+
+  for (key Index = 0; Index < Count; Index++)
+  {
+    u32 Value;
+    memcpy(&Value, Input + Index * 4, sizeof(Value));
+    Value = __SPAN__LE32(Value);
+    memcpy(&Output[Index], &Value, sizeof(Value));
+  }
+
+  Span->Offset += Count * 4;
+}
+
+inline void ReadF32BE(span *Span, f32 *Output, const key Count)
+{
+  Assert(HasSpan(Span, Count * 4), "Span reading went out of bounds.");
+  const byte *Input = Span->Offset;
+
+  for (key Index = 0; Index < Count; Index++)
+  {
+    u32 Value;
+    memcpy(&Value, Input + Index * 4, sizeof(Value));
+    Value = __SPAN__BE32(Value);
+    memcpy(&Output[Index], &Value, sizeof(Value));
+  }
+
+  Span->Offset += Count * 4;
+}
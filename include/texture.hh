@@ -19,6 +19,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include <common.hh>
+#include <allocators/allocator.hh>
+
+// libc
+#include <string.h>
 
 struct pixel
 {
@@ -31,12 +35,44 @@ struct texture
   pixel *Pixels;
 };
 
+// Pixels start zeroed, a texture without any has Pixels set to 0x0 with either overload.
 inline texture *CreateEmptyTexture(const key Width, const key Height)
 {
   texture *Result = SysAllocate(texture, 1);
   Result->Width = Width;
   Result->Height = Height;
-  Result->Pixels = SysAllocate(pixel, Width * Height);
+  Result->Pixels = Width * Height ? SysAllocate(pixel, Width * Height) : 0x0;
+  return Result;
+};
+
+// Arenas hand back recycled memory, the pixels are cleared to match the SysAllocate overload.
+template <typename A>
+inline texture *CreateEmptyTexture(A *Allocator, const key Width, const key Height)
+{
+  texture *Result = Allocate(Allocator, texture);
+
+  if (!Result)
+  {
+    return 0x0;
+  }
+
+  key Count = Width * Height;
+  Result->Width = Width;
+  Result->Height = Height;
+  Result->Pixels = 0x0;
+
+  if (Count)
+  {
+    Result->Pixels = AllocateN(Allocator, pixel, Count);
+
+    if (!Result->Pixels)
+    {
+      return 0x0;
+    }
+
+    memset(Result->Pixels, 0, sizeof(pixel) * Count);
+  }
+
   return Result;
 };
 
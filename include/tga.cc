@@ -18,36 +18,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "tga.hh"
 
-inline byte Read8(tga::reader *Reader)
-{
-  byte Result = Reader->Offset[0];
-  Reader->Offset++;
-  return Result;
-}
-
-inline u32 Read32LE(tga::reader *Reader)
-{
-  u32 Result = u32(Reader->Offset[3] << 24 | Reader->Offset[2] << 16 | Reader->Offset[1] << 8 |
-                   Reader->Offset[0]);
-  Reader->Offset += 4;
-  return Result;
-}
-
-inline u32 Read24LE(tga::reader *Reader)
-{
-  u32 Result = u32(Reader->Offset[2] << 16 | Reader->Offset[1] << 8 | Reader->Offset[0]);
-  Reader->Offset += 3;
-  return Result;
-}
-
-inline word Read16LE(tga::reader *Reader)
-{
-  word Result = word(Reader->Offset[1] << 8 | Reader->Offset[0]);
-  Reader->Offset += 2;
-  return Result;
-}
-
-inline pixel Read32RGBA(tga::reader *Reader)
+inline pixel Read32RGBA(span *Reader)
 {
   pixel Result = pixel{
       .R = Reader->Offset[2],
@@ -60,7 +31,7 @@ inline pixel Read32RGBA(tga::reader *Reader)
   return Result;
 }
 
-inline pixel Read24RGB(tga::reader *Reader)
+inline pixel Read24RGB(span *Reader)
 {
   pixel Result = pixel{
       .R = Reader->Offset[2],
@@ -73,7 +44,7 @@ inline pixel Read24RGB(tga::reader *Reader)
   return Result;
 }
 
-inline pixel Read16RGB(tga::reader *Reader)
+inline pixel Read16RGB(span *Reader)
 {
   pixel Result = {
       .R = byte((Reader->Offset[1] & 0x7c) << 1),
@@ -86,13 +57,20 @@ inline pixel Read16RGB(tga::reader *Reader)
   return Result;
 }
 
-inline pixel ReadColorTable(const byte *Table, const word Origin, const word Length,
+// TableLength is the size in bytes of the color map that was bounds checked
+inline pixel ReadColorTable(const byte *Table, const key TableLength, const word Origin,
                             const byte Depth, const key Index)
 {
   key DepthByteLength = Depth / 8;
-  key ByteOffset = (Origin * DepthByteLength) + (Index * DepthByteLength);
+  key ByteOffset = (Origin + Index) * DepthByteLength;
+
+  // indices past the table would read beyond the color map
+  if (ByteOffset + DepthByteLength > TableLength)
+  {
+    return pixel{0, 0, 0, 0};
+  }
 
-  tga::reader TempReader = {.Offset = Table + ByteOffset};
+  span TempReader = Span(DepthByteLength, Table + ByteOffset);
 
   switch (Depth)
   {
@@ -107,7 +85,7 @@ inline pixel ReadColorTable(const byte *Table, const word Origin, const word Len
   };
 }
 
-inline pixel ReadPixelData(tga::reader *Reader, const byte Depth)
+inline pixel ReadPixelData(span *Reader, const byte Depth)
 {
   switch (Depth)
   {
@@ -122,140 +100,208 @@ inline pixel ReadPixelData(tga::reader *Reader, const byte Depth)
   };
 }
 
-texture *tga::Decompress(const key Length, const void *Data, i32 *ErrorCode)
+// Decodes Count pixels the caller already bounds checked, the depth switch is hoisted out of the
+// loops so each one is a straight swizzle.
+inline void ReadPixelRun(span *Reader, const byte Depth, pixel *Output, const key Count)
 {
-  if (sizeof(tga::header) >= Length)
+  switch (Depth)
   {
-    if (ErrorCode)
+  case 16:
+    for (key Index = 0; Index < Count; Index++)
     {
-      *ErrorCode = tga::ERROR_CODE_DATA_SIZE;
+      Output[Index] = Read16RGB(Reader);
     }
-    return 0x0;
+    break;
+  case 24:
+    for (key Index = 0; Index < Count; Index++)
+    {
+      Output[Index] = Read24RGB(Reader);
+    }
+    break;
+  case 32:
+    for (key Index = 0; Index < Count; Index++)
+    {
+      Output[Index] = Read32RGBA(Reader);
+    }
+    break;
+  default:
+    memset(Output, 0, sizeof(pixel) * Count);
+    break;
+  };
+}
+
+inline key ReadColorIndex(span *Reader, const byte Depth)
+{
+  switch (Depth)
+  {
+  case 8:
+    return Read8(Reader);
+  case 16:
+    return Read16LE(Reader);
+  case 24:
+    return Read24LE(Reader);
+  default:
+    return Read32LE(Reader);
+  };
+}
+
+i32 tga::ReadHeader(const key Length, const void *Data, tga::header *Header, span *Reader)
+{
+  if (sizeof(tga::header) >= Length)
+  {
+    return tga::ERROR_CODE_DATA_SIZE;
   }
 
-  tga::reader Reader = {.Offset = (byte *)Data};
+  *Reader = Span(Length, Data);
+
+  Header->IdLength = Read8(Reader);
+  Header->ColorMapType = Read8(Reader);
+  Header->DataTypeCode = Read8(Reader);
+  Header->ColorMapOrigin = Read16LE(Reader);
+  Header->ColorMapLength = Read16LE(Reader);
+  Header->ColorMapDepth = Read8(Reader);
+  Header->OriginX = Read16LE(Reader);
+  Header->OriginY = Read16LE(Reader);
+  Header->Width = Read16LE(Reader);
+  Header->Height = Read16LE(Reader);
+  Header->PixelDepth = Read8(Reader);
+  Header->ImageDescriptor = Read8(Reader);
+
+  if (!HasSpan(Reader, Header->IdLength))
+  {
+    return tga::ERROR_CODE_DATA_SIZE;
+  }
 
-  tga::header Header;
-  Header.IdLength = Read8(&Reader);
-  Header.ColorMapType = Read8(&Reader);
-  Header.DataTypeCode = Read8(&Reader);
-  Header.ColorMapOrigin = Read16LE(&Reader);
-  Header.ColorMapLength = Read16LE(&Reader);
-  Header.ColorMapDepth = Read8(&Reader);
-  Header.OriginX = Read16LE(&Reader);
-  Header.OriginY = Read16LE(&Reader);
-  Header.Width = Read16LE(&Reader);
-  Header.Height = Read16LE(&Reader);
-  Header.PixelDepth = Read8(&Reader);
-  Header.ImageDescriptor = Read8(&Reader);
-
-  Reader.Offset += Header.IdLength;
+  SkipSpan(Reader, Header->IdLength);
+
+  if (!(Header->DataTypeCode == 1 || Header->DataTypeCode == 2 || Header->DataTypeCode == 10))
+  {
+    return tga::ERROR_CODE_DATA_TYPE;
+  }
+
+  // color mapped images need the map they index into
+  if (!(Header->ColorMapType == 0 || Header->ColorMapType == 1) ||
+      (Header->DataTypeCode == 1 && Header->ColorMapType != 1))
+  {
+    return tga::ERROR_CODE_COLOR_MAP_TYPE;
+  }
+
+  if (!(Header->PixelDepth == 8 || Header->PixelDepth == 16 || Header->PixelDepth == 24 ||
+        Header->PixelDepth == 32))
+  {
+    return tga::ERROR_CODE_PIXEL_DEPTH;
+  }
+
+  return tga::ERROR_CODE_SUCCESS;
+}
+
+bool32 tga::DecodePixels(const tga::header *Header, span Reader, texture *Output)
+{
+  key ColorMapSize = Header->ColorMapType * Header->ColorMapLength * (Header->ColorMapDepth / 8);
+
+  if (!HasSpan(&Reader, ColorMapSize))
+  {
+    return false;
+  }
 
   const byte *ColorMapData = Reader.Offset;
-  Reader.Offset += Header.ColorMapType * Header.ColorMapLength * (Header.ColorMapDepth / 8);
+  SkipSpan(&Reader, ColorMapSize);
+
+  key DataSize = Header->Width * Header->Height;
+  key Depth = Header->PixelDepth / 8;
 
-  if (!(Header.DataTypeCode == 1 || Header.DataTypeCode == 2 || Header.DataTypeCode == 10))
+  if (Header->DataTypeCode == 1 || Header->DataTypeCode == 2)
   {
-    if (ErrorCode)
+    // uncompressed data, a single check covers every pixel
+    if (!HasSpan(&Reader, DataSize * Depth))
     {
-      *ErrorCode = tga::ERROR_CODE_DATA_TYPE;
+      return false;
     }
-    return 0x0;
-  }
 
-  if (!(Header.ColorMapType == 0 || Header.ColorMapType == 1))
-  {
-    if (ErrorCode)
+    if (Header->DataTypeCode == 2)
     {
-      *ErrorCode = tga::ERROR_CODE_COLOR_MAP_TYPE;
+      ReadPixelRun(&Reader, Header->PixelDepth, Output->Pixels, DataSize);
+      return true;
     }
-    return 0x0;
-  }
 
-  if (!(Header.PixelDepth == 8 || Header.PixelDepth == 16 || Header.PixelDepth == 24 ||
-        Header.PixelDepth == 32))
-  {
-    if (ErrorCode)
+    for (key N = 0; N < DataSize; N++)
     {
-      *ErrorCode = tga::ERROR_CODE_PIXEL_DEPTH;
+      key ColorIndex = ReadColorIndex(&Reader, Header->PixelDepth);
+      Output->Pixels[N] = ReadColorTable(ColorMapData, ColorMapSize, Header->ColorMapOrigin,
+                                         Header->ColorMapDepth, ColorIndex);
     }
-    return 0x0;
-  }
 
-  pixel PixelData;
-  key N = 0, I, J, RLEChunk, ColorIndex;
+    return true;
+  }
 
-  texture *Result = CreateEmptyTexture(Header.Width, Header.Height);
-  key DataSize = Header.Width * Header.Height;
+  // compressed non-colormap data, checked once per packet
+  key N = 0;
 
   while (N < DataSize)
   {
-    if (Header.DataTypeCode == 1)
+    if (!HasSpan(&Reader, 1))
     {
-      // uncompressed data
-      switch (Header.PixelDepth)
-      {
-      case 8:
-        ColorIndex = Read8(&Reader);
-        break;
-      case 16:
-        ColorIndex = Read16LE(&Reader);
-        break;
-      case 24:
-        ColorIndex = Read24LE(&Reader);
-        break;
-      case 32:
-        ColorIndex = Read32LE(&Reader);
-        break;
-      default:
-        return 0x0;
-      };
-
-      Result->Pixels[N] = ReadColorTable(ColorMapData, Header.ColorMapOrigin, Header.ColorMapLength,
-                                         Header.ColorMapDepth, ColorIndex);
-      N++;
+      return false;
     }
-    else if (Header.DataTypeCode == 2)
+
+    byte Packet = Read8(&Reader);
+    key Count = (Packet & 0x7f) + 1;
+    bool32 RLEChunk = Packet & 0x80;
+
+    if (Count > DataSize - N || !HasSpan(&Reader, RLEChunk ? Depth : Count * Depth))
     {
-      // uncompressed non-colormap data
-      PixelData = ReadPixelData(&Reader, Header.PixelDepth);
+      return false;
+    }
 
-      Result->Pixels[N] = PixelData;
-      N++;
+    if (RLEChunk)
+    {
+      // RLE chunk
+      pixel PixelData = ReadPixelData(&Reader, Header->PixelDepth);
+
+      for (key I = 0; I < Count; I++)
+      {
+        Output->Pixels[N + I] = PixelData;
+      }
     }
-    else if (Header.DataTypeCode == 10)
+    else
     {
-      // compressed non-colormap chunk
-      J = Reader.Offset[0] & 0x7f;
-      RLEChunk = Reader.Offset[0] & 0x80;
+      // normal chunk
+      ReadPixelRun(&Reader, Header->PixelDepth, Output->Pixels + N, Count);
+    }
 
-      Reader.Offset++;
-      PixelData = ReadPixelData(&Reader, Header.PixelDepth);
+    N += Count;
+  }
 
-      Result->Pixels[N] = PixelData;
-      N++;
+  return true;
+}
 
-      if (RLEChunk)
-      {
-        // RLE chunk
-        for (I = 0; I < J; I++)
-        {
-          Result->Pixels[N] = PixelData;
-          N++;
-        }
-      }
-      else
-      {
-        // normal chunk
-        for (I = 0; I < J; I++)
-        {
-          PixelData = ReadPixelData(&Reader, Header.PixelDepth);
-
-          Result->Pixels[N] = PixelData;
-          N++;
-        }
-      }
+texture *tga::Decompress(const key Length, const void *Data, i32 *ErrorCode)
+{
+  tga::header Header;
+  span Reader;
+  i32 Error = tga::ReadHeader(Length, Data, &Header, &Reader);
+
+  if (Error != tga::ERROR_CODE_SUCCESS)
+  {
+    if (ErrorCode)
+    {
+      *ErrorCode = Error;
     }
+    return 0x0;
+  }
+
+  texture *Result = CreateEmptyTexture(Header.Width, Header.Height);
+
+  if (!tga::DecodePixels(&Header, Reader, Result))
+  {
+    SysFree(Result->Pixels);
+    SysFree(Result);
+
+    if (ErrorCode)
+    {
+      *ErrorCode = tga::ERROR_CODE_DATA_SIZE;
+    }
+    return 0x0;
   }
 
   return Result;
@@ -19,6 +19,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include <common.hh>
+#include "span.hh"
 #include "texture.hh"
 
 namespace tga
@@ -26,15 +27,11 @@ namespace tga
 enum error_code
 {
   ERROR_CODE_SUCCESS = 0,
-  ERROR_CODE_DATA_SIZE = 1,      // Data size was smaller than header
+  ERROR_CODE_DATA_SIZE = 1,      // Data size was smaller than the header or the pixels it lists
   ERROR_CODE_DATA_TYPE = 2,      // Can only handle image type 1, 2 and 10
-  ERROR_CODE_COLOR_MAP_TYPE = 3, // Can only handle color map types of 0 and 1
+  ERROR_CODE_COLOR_MAP_TYPE = 3, // Can only handle color map types of 0 and 1, type 1 needs a map
   ERROR_CODE_PIXEL_DEPTH = 4,    // Can only handle pixel depths of 8, 16, 24, and 32
-};
-
-struct reader
-{
-  const byte *Offset;
+  ERROR_CODE_ALLOCATION = 5,     // Allocator had no room left for the texture
 };
 
 struct header
@@ -53,6 +50,55 @@ struct header
   byte ImageDescriptor;
 };
 
+// Reader is left on the color map, which is directly followed by the pixel data
+i32 ReadHeader(const key Length, const void *Data, tga::header *Header, span *Reader);
+bool32 DecodePixels(const tga::header *Header, span Reader, texture *Output);
+
 texture *Decompress(const key Length, const void *Data);
 texture *Decompress(const key Length, const void *Data, i32 *ErrorCode);
+
+template <typename A>
+texture *Decompress(A *Allocator, const key Length, const void *Data, i32 *ErrorCode)
+{
+  tga::header Header;
+  span Reader;
+  i32 Error = tga::ReadHeader(Length, Data, &Header, &Reader);
+
+  if (Error != tga::ERROR_CODE_SUCCESS)
+  {
+    if (ErrorCode)
+    {
+      *ErrorCode = Error;
+    }
+    return 0x0;
+  }
+
+  texture *Result = CreateEmptyTexture(Allocator, Header.Width, Header.Height);
+
+  if (!Result)
+  {
+    Error = tga::ERROR_CODE_ALLOCATION;
+  }
+  else if (!tga::DecodePixels(&Header, Reader, Result))
+  {
+    // the texture stays in the allocator until the caller releases it
+    Error = tga::ERROR_CODE_DATA_SIZE;
+  }
+
+  if (Error != tga::ERROR_CODE_SUCCESS)
+  {
+    if (ErrorCode)
+    {
+      *ErrorCode = Error;
+    }
+    return 0x0;
+  }
+
+  return Result;
+}
+
+template <typename A> texture *Decompress(A *Allocator, const key Length, const void *Data)
+{
+  return tga::Decompress(Allocator, Length, Data, 0x0);
+}
 }; // namespace tga